@@ -0,0 +1,915 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 Xavier RX Tan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in the
+Software without restriction, including without limitation the rights to use, copy,
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the
+following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/****************************************************
+Author : Xavier Tan
+Email  : xavier.rx.tan@gmail.com / tan.ruixiang@digipen.edu
+
+Benchmark.cpp
+
+*****************************************************/
+
+/**
+	\file Benchmark.cpp
+	\brief
+		Reproducible benchmark of the VMM against the system malloc and free. Every workload 
+		runs on every allocator with the same seeded sequence of requests, and reports
+		- throughput in million operations per second
+		- p50, p99 and p999 latency of a single Allocate or Free in nanoseconds
+		- growth of the resident set size at the workload's peak
+		- peak of the bytes requested and live at the same time
+		- external fragmentation, for the allocators that can tell
+
+		Usage : Benchmark [operations] [threads]
+
+		Every allocation and deallocation is timed individually, so the clock overhead is part of
+		every figure, equally for every allocator. Since the system heap keeps memory it got from 
+		the OS, resident set figures are only comparable for the first workload run in a process; 
+		run a single workload per process by passing its name as a third argument for clean ones.
+		An other malloc, jemalloc for instance, is benchmarked by preloading it.
+*/
+
+#include "../MemoryManager/MemoryManager.h"
+#include "../MemoryManager/ConcurrentMemoryManager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <unistd.h>
+#endif
+
+typedef std::chrono::steady_clock BenchmarkClock;
+
+/*
+*	\brief
+*	xorshift generator, gives the same sequence of requests on every platform
+*/
+class Random
+{
+public:
+	explicit Random( std::uint32_t seed ) : state(seed ? seed : 1) {}
+
+	std::uint32_t Next()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	/*
+	*	\brief
+	*	Uniform in [low, high]
+	*/
+	unsigned Range( unsigned low, unsigned high )
+	{
+		return low + Next() % ( high - low + 1 );
+	}
+
+private:
+	std::uint32_t state;
+};
+
+/*
+*	\brief
+*	Bytes of the process resident in physical memory, 0 where it cannot be read
+*/
+static std::size_t ResidentBytes()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if ( !GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) )
+		return 0;
+
+	return counters.WorkingSetSize;
+#else
+	std::ifstream statm("/proc/self/statm");
+	std::size_t pages = 0, resident = 0;
+
+	statm >> pages >> resident;
+
+	return resident * static_cast<std::size_t>( sysconf(_SC_PAGESIZE) );
+#endif
+}
+
+/*
+*	\brief
+*	Latencies and memory figures gathered by one thread of a workload. 
+*	Everything is sized before the workload starts so the recorder 
+*	never allocates while being measured.
+*/
+class Recorder
+{
+public:
+	explicit Recorder( std::size_t capacity ) : latencies(capacity), count(0), liveBytes(0), peakLiveBytes(0), peakResident(0), baseResident(ResidentBytes()), 
+											   sampledLiveBytes(0), fragmentation(-1.0) {}
+
+	void Record( BenchmarkClock::time_point start )
+	{
+		if ( count < latencies.size() )
+			latencies[count++] = static_cast<std::uint32_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( BenchmarkClock::now() - start ).count() );
+	}
+
+	void Allocated( BenchmarkClock::time_point start, unsigned size )
+	{
+		Record(start);
+
+		liveBytes += size;
+
+		if ( liveBytes > peakLiveBytes )
+			peakLiveBytes = liveBytes;
+	}
+
+	void Freed( BenchmarkClock::time_point start, unsigned size )
+	{
+		Record(start);
+
+		liveBytes -= size;
+	}
+
+	/*
+	*	\brief
+	*	Called by the workloads where they hold the most memory. The fragmentation 
+	*	is kept from the sample taken with the most bytes live.
+	*/
+	template <typename Heap>
+	void Sample( const Heap& heap )
+	{
+		std::size_t resident = ResidentBytes();
+
+		if ( resident > peakResident )
+			peakResident = resident;
+
+		if ( liveBytes >= sampledLiveBytes )
+		{
+			sampledLiveBytes = liveBytes;
+			fragmentation = heap.Fragmentation();
+		}
+	}
+
+	std::vector<std::uint32_t> latencies;	/**< nanoseconds per operation*/
+	std::size_t count;						/**< operations recorded*/
+	std::size_t liveBytes;					/**< bytes currently requested*/
+	std::size_t peakLiveBytes;				/**< most bytes requested at once*/
+	std::size_t peakResident;				/**< largest resident set sampled*/
+	std::size_t baseResident;				/**< resident set before the workload*/
+	std::size_t sampledLiveBytes;			/**< bytes live at the busiest sample*/
+	double		fragmentation;				/**< external fragmentation at the busiest sample, negative when unknown*/
+};
+
+/*
+*	\brief
+*	The system heap
+*/
+class MallocHeap
+{
+public:
+	static const char* Name() { return "malloc"; }
+
+	void* Allocate( unsigned size ) { return malloc(size); }
+
+	void Free( void* object ) { free(object); }
+
+	double Fragmentation() const { return -1.0; }
+};
+
+/*
+*	\brief
+*	A single VMM, with the boundary tag or the bitmap layout, and for 
+*	the boundary tag layout one of the placement policies
+*/
+template <METADATA_LAYOUT Layout, class Fit = WorstFit>
+class VmmHeap
+{
+public:
+	VmmHeap() : manager(256 * MEM_SIZE::KILO_BYTE, 50, true, PAGE_SOURCE_HEAP, Layout) {}
+
+	static const char* Name()
+	{
+		static const std::string name = LAYOUT_BITMAP == Layout ? std::string("VMM bitmap") : std::string("VMM ") + Fit::Name();
+
+		return name.c_str();
+	}
+
+	void* Allocate( unsigned size ) { return manager.Allocate(size); }
+
+	void Free( void* object ) { manager.Free(object); }
+
+	double Fragmentation() const { return manager.GetStats().externalFragmentation; }
+
+private:
+	BasicVariableMemoryManager<Fit> manager;
+};
+
+/*
+*	\brief
+*	The thread safe front end, one VMM per thread
+*/
+class ConcurrentHeap
+{
+public:
+	ConcurrentHeap() : manager(256 * MEM_SIZE::KILO_BYTE, 50) {}
+
+	static const char* Name() { return "VMM concurrent"; }
+
+	void* Allocate( unsigned size ) { return manager.Allocate(size); }
+
+	void Free( void* object ) { manager.Free(object); }
+
+	double Fragmentation() const { return -1.0; }
+
+private:
+	ConcurrentMemoryManager manager;
+};
+
+/*
+*	\brief
+*	A live block and the size it was requested with
+*/
+struct Block
+{
+	void*	 object;
+	unsigned size;
+};
+
+/*
+*	\brief
+*	Allocate a block and record its latency
+*/
+template <typename Heap>
+static Block TimedAllocate( Heap& heap, Recorder& recorder, unsigned size )
+{
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+
+	Block block = { heap.Allocate(size), size };
+
+	recorder.Allocated(start, size);
+
+	return block;
+}
+
+/*
+*	\brief
+*	Free a block and record its latency
+*/
+template <typename Heap>
+static void TimedFree( Heap& heap, Recorder& recorder, Block& block )
+{
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+
+	heap.Free(block.object);
+
+	recorder.Freed(start, block.size);
+
+	block.object = nullptr;
+}
+
+/*
+*	\brief
+*	A size spread evenly over the powers of two from 8 to 2048 bytes, the way small object requests usually are
+*/
+static unsigned ChurnSize( Random& random )
+{
+	unsigned base = 8u << ( random.Next() % 8 );
+
+	return base + random.Next() % base;
+}
+
+/*
+*	\brief
+*	Random size churn. A fixed table of slots is hit at random, an empty slot 
+*	is filled and a full one is emptied, so about half the table stays live.
+*/
+template <typename Heap>
+static void RandomChurn( Heap& heap, Recorder& recorder, unsigned operations, std::uint32_t seed )
+{
+	const unsigned slotCount = 4096;
+
+	std::vector<Block> slots(slotCount);
+	Random random(seed);
+
+	for ( unsigned i = 0; i < slotCount; ++i )
+		slots[i].object = nullptr;
+
+	for ( unsigned op = 0; op < operations; ++op )
+	{
+		Block& slot = slots[random.Next() % slotCount];
+
+		if ( slot.object )
+			TimedFree(heap, recorder, slot);
+		else
+			slot = TimedAllocate(heap, recorder, ChurnSize(random));
+
+		if ( 0 == ( op & 1023 ) )
+			recorder.Sample(heap);
+	}
+
+	for ( unsigned i = 0; i < slotCount; ++i )
+	{
+		if ( slots[i].object )
+			TimedFree(heap, recorder, slots[i]);
+	}
+}
+
+/*
+*	\brief
+*	Batches allocated together and released in the reverse order, as a stack, 
+*	then batches released in the order they were allocated, as a queue
+*/
+template <typename Heap>
+static void LifoFifo( Heap& heap, Recorder& recorder, unsigned operations, std::uint32_t seed )
+{
+	const unsigned batchSize = 1000;
+
+	std::vector<Block> batch(batchSize);
+	Random random(seed);
+
+	for ( unsigned op = 0; op < operations; op += 4 * batchSize )
+	{
+		for ( unsigned i = 0; i < batchSize; ++i )
+			batch[i] = TimedAllocate(heap, recorder, random.Range(16, 512));
+
+		recorder.Sample(heap);
+
+		for ( unsigned i = batchSize; i-- > 0; )
+			TimedFree(heap, recorder, batch[i]);
+
+		for ( unsigned i = 0; i < batchSize; ++i )
+			batch[i] = TimedAllocate(heap, recorder, random.Range(16, 512));
+
+		recorder.Sample(heap);
+
+		for ( unsigned i = 0; i < batchSize; ++i )
+			TimedFree(heap, recorder, batch[i]);
+	}
+}
+
+/*
+*	\brief
+*	Game levels loaded and unloaded in turn. A level is mostly vertex sized records, 
+*	some mesh and material sized ones and a few texture sized ones. A tenth of the 
+*	assets are shared with the next level and only unloaded with it, which leaves 
+*	holes between the assets of the following level.
+*/
+template <typename Heap>
+static void AssetLevels( Heap& heap, Recorder& recorder, unsigned operations, std::uint32_t seed )
+{
+	const unsigned assetsPerLevel = 2000;
+
+	std::vector<Block> level;
+	std::vector<Block> shared;
+	std::vector<Block> nextShared;
+	Random random(seed);
+
+	level.reserve(assetsPerLevel);
+	shared.reserve(assetsPerLevel);
+	nextShared.reserve(assetsPerLevel);
+
+	for ( unsigned op = 0; op < operations; op += 2 * assetsPerLevel )
+	{
+		for ( unsigned i = 0; i < assetsPerLevel; ++i )
+		{
+			unsigned kind = random.Next() % 100;
+			unsigned size = kind < 70 ? random.Range(28, 64) : kind < 95 ? random.Range(256, 4096) : random.Range(16384, 65536);
+
+			Block block = TimedAllocate(heap, recorder, size);
+
+			if ( random.Next() % 10 )
+				level.push_back(block);
+			else
+				nextShared.push_back(block);
+		}
+
+		recorder.Sample(heap);
+
+		// the level is unloaded in no particular order, along with what the previous level shared
+		for ( std::size_t i = level.size(); i > 1; --i )
+			std::swap(level[i - 1], level[random.Next() % i]);
+
+		for ( std::size_t i = 0; i < level.size(); ++i )
+			TimedFree(heap, recorder, level[i]);
+
+		for ( std::size_t i = 0; i < shared.size(); ++i )
+			TimedFree(heap, recorder, shared[i]);
+
+		level.clear();
+		shared.swap(nextShared);
+		nextShared.clear();
+	}
+
+	for ( std::size_t i = 0; i < shared.size(); ++i )
+		TimedFree(heap, recorder, shared[i]);
+}
+
+/*
+*	\brief
+*	Work of one thread of the multithreaded workload. A random size churn where every 
+*	16th block is handed to the next thread through a mailbox and released over there.
+*/
+template <typename Heap>
+static void ThreadChurn( Heap* heap, Recorder* recorder, std::atomic<void*>* mailboxes, unsigned self, 
+						 unsigned threads, unsigned operations, std::uint32_t seed )
+{
+	const unsigned slotCount = 1024;
+
+	std::vector<Block> slots(slotCount);
+	Random random(seed + self);
+
+	for ( unsigned i = 0; i < slotCount; ++i )
+		slots[i].object = nullptr;
+
+	for ( unsigned op = 0; op < operations; ++op )
+	{
+		Block& slot = slots[random.Next() % slotCount];
+
+		if ( slot.object )
+		{
+			TimedFree(*heap, *recorder, slot);
+		}
+		else if ( 0 == ( op & 15 ) )
+		{
+			Block block = TimedAllocate(*heap, *recorder, ChurnSize(random));
+
+			// the receiving thread does not know the size, the bytes are accounted as freed right away
+			recorder->liveBytes -= block.size;
+
+			void* received = mailboxes[self].exchange(nullptr);
+			void* unclaimed = mailboxes[( self + 1 ) % threads].exchange(block.object);
+
+			if ( received )
+				heap->Free(received);
+
+			if ( unclaimed )
+				heap->Free(unclaimed);
+		}
+		else
+		{
+			slot = TimedAllocate(*heap, *recorder, ChurnSize(random));
+		}
+
+		if ( 0 == self && 0 == ( op & 1023 ) )
+			recorder->Sample(*heap);
+	}
+
+	for ( unsigned i = 0; i < slotCount; ++i )
+	{
+		if ( slots[i].object )
+			TimedFree(*heap, *recorder, slots[i]);
+	}
+}
+
+/*
+*	\brief
+*	Figures of one workload on one allocator
+*/
+struct Result
+{
+	double		  seconds;			/**< wall clock time of the workload*/
+	std::size_t	  operations;		/**< allocations and frees timed*/
+	std::uint32_t p50;				/**< median latency*/
+	std::uint32_t p99;				/**< 99th percentile latency*/
+	std::uint32_t p999;				/**< 99.9th percentile latency*/
+	std::size_t	  residentGrowth;	/**< resident set at the peak minus before the workload*/
+	std::size_t	  peakLiveBytes;	/**< most bytes requested at once*/
+	double		  fragmentation;	/**< external fragmentation at the busiest sample, negative when unknown*/
+};
+
+/*
+*	\brief
+*	Latency at the given fraction of the sorted latencies
+*/
+static std::uint32_t Percentile( const std::vector<std::uint32_t>& sorted, double fraction )
+{
+	if ( sorted.empty() )
+		return 0;
+
+	std::size_t index = static_cast<std::size_t>( fraction * sorted.size() );
+
+	return sorted[ index < sorted.size() ? index : sorted.size() - 1 ];
+}
+
+/*
+*	\brief
+*	Fold the recorders of a workload into its result
+*/
+static Result Summarize( std::vector<Recorder*>& recorders, double seconds )
+{
+	Result result;
+	std::vector<std::uint32_t> latencies;
+
+	result.seconds = seconds;
+	result.operations = 0;
+	result.residentGrowth = 0;
+	result.peakLiveBytes = 0;
+	result.fragmentation = -1.0;
+
+	for ( std::size_t i = 0; i < recorders.size(); ++i )
+	{
+		Recorder& recorder = *recorders[i];
+
+		latencies.insert(latencies.end(), recorder.latencies.begin(), recorder.latencies.begin() + recorder.count);
+
+		result.operations += recorder.count;
+		result.peakLiveBytes += recorder.peakLiveBytes;
+
+		if ( recorder.fragmentation > result.fragmentation )
+			result.fragmentation = recorder.fragmentation;
+
+		if ( recorder.peakResident > recorder.baseResident )
+			result.residentGrowth = std::max(result.residentGrowth, recorder.peakResident - recorder.baseResident);
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+
+	result.p50 = Percentile(latencies, 0.5);
+	result.p99 = Percentile(latencies, 0.99);
+	result.p999 = Percentile(latencies, 0.999);
+
+	return result;
+}
+
+/*
+*	\brief
+*	Print one line of the report
+*/
+static void Report( const char* workload, const char* allocator, const Result& result )
+{
+	std::cout << workload << "\t" << allocator
+			  << "\t" << result.operations / result.seconds / 1000000.0
+			  << "\t" << result.p50 << "\t" << result.p99 << "\t" << result.p999
+			  << "\t" << result.residentGrowth / MEM_SIZE::KILO_BYTE
+			  << "\t" << result.peakLiveBytes / MEM_SIZE::KILO_BYTE << "\t";
+
+	if ( result.fragmentation < 0.0 )
+		std::cout << "-";
+	else
+		std::cout << result.fragmentation;
+
+	std::cout << std::endl;
+}
+
+/*
+*	\brief
+*	Signature shared by the single threaded workloads
+*/
+template <typename Heap>
+struct Workload
+{
+	typedef void (*Function)( Heap&, Recorder&, unsigned, std::uint32_t );
+};
+
+/*
+*	\brief
+*	Run a single threaded workload on a fresh heap
+*/
+template <typename Heap>
+static void RunSingle( const char* name, typename Workload<Heap>::Function workload, unsigned operations )
+{
+	Recorder recorder(2 * operations + 65536);
+	std::vector<Recorder*> recorders(1, &recorder);
+
+	Heap* heap = new Heap;
+
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+
+	workload(*heap, recorder, operations, 2016);
+
+	std::chrono::duration<double> elapsed = BenchmarkClock::now() - start;
+
+	delete heap;
+
+	Report(name, Heap::Name(), Summarize(recorders, elapsed.count()));
+}
+
+/*
+*	\brief
+*	Run the multithreaded workload on a fresh heap shared by every thread
+*/
+template <typename Heap>
+static void RunThreaded( const char* name, unsigned operations, unsigned threads )
+{
+	std::vector<Recorder*> recorders;
+	std::vector<std::atomic<void*> > mailboxes(threads);
+	std::vector<std::thread> workers;
+
+	for ( unsigned i = 0; i < threads; ++i )
+	{
+		recorders.push_back(new Recorder(2 * operations / threads + 4096));
+		mailboxes[i] = nullptr;
+	}
+
+	Heap* heap = new Heap;
+
+	BenchmarkClock::time_point start = BenchmarkClock::now();
+
+	for ( unsigned i = 0; i < threads; ++i )
+		workers.push_back(std::thread(ThreadChurn<Heap>, heap, recorders[i], &mailboxes[0], i, threads, operations / threads, 2016));
+
+	for ( unsigned i = 0; i < threads; ++i )
+		workers[i].join();
+
+	std::chrono::duration<double> elapsed = BenchmarkClock::now() - start;
+
+	for ( unsigned i = 0; i < threads; ++i )
+	{
+		if ( mailboxes[i].load() )
+			heap->Free(mailboxes[i].load());
+	}
+
+	delete heap;
+
+	Report(name, Heap::Name(), Summarize(recorders, elapsed.count()));
+
+	for ( unsigned i = 0; i < threads; ++i )
+		delete recorders[i];
+}
+
+/*
+*	\brief
+*	Measures the average latency of Free while the heap grows from 1 to 10k pages.
+*	Each allocation is larger than half a page, so every one of them lands in its own page.
+*/
+void FreeLatencyBenchmark()
+{
+	const unsigned pageSize = 4 * MEM_SIZE::KILO_BYTE;
+	const unsigned blockSize = pageSize / 2 + 1;
+
+	std::cout << "Free latency benchmark" << std::endl;
+
+	for ( unsigned pages = 1; pages <= 10000; pages *= 10 )
+	{
+		VariableMemoryManager manager(pageSize, 50);
+
+		void** blocks = new void*[pages];
+
+		for ( unsigned i = 0; i < pages; ++i )
+			blocks[i] = manager.Allocate(blockSize);
+
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+
+		// free from the most recently requested page backwards,
+		// which was the slowest order for the page walk
+		for ( unsigned i = pages; i > 0; --i )
+			manager.Free(blocks[i - 1]);
+
+		std::chrono::duration<double, std::nano> elapsed = BenchmarkClock::now() - start;
+
+		std::cout << "Pages : " << pages << "\tns per Free : " << elapsed.count() / pages << std::endl;
+
+		delete [] blocks;
+	}
+}
+
+/*
+*	\brief
+*	Times allocations that fit none of the pages held, each more than half full, so each one 
+*	ends up requesting a page. The page index rules out every page held at once.
+*/
+void PageSelectionBenchmark()
+{
+	const unsigned pageSize = 4 * MEM_SIZE::KILO_BYTE;
+	const unsigned blockSize = pageSize / 2 + 1;
+
+	std::cout << "Page selection benchmark" << std::endl;
+
+	for ( unsigned pages = 10; pages <= 10000; pages *= 10 )
+	{
+		VariableMemoryManager manager(pageSize, 50);
+
+		void** blocks = new void*[2 * pages];
+
+		for ( unsigned i = 0; i < pages; ++i )
+			blocks[i] = manager.Allocate(blockSize);
+
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+
+		for ( unsigned i = pages; i < 2 * pages; ++i )
+			blocks[i] = manager.Allocate(blockSize);
+
+		std::chrono::duration<double, std::nano> elapsed = BenchmarkClock::now() - start;
+
+		std::cout << "Pages : " << pages << "\tns per Allocate : " << elapsed.count() / pages << std::endl;
+
+		for ( unsigned i = 0; i < 2 * pages; ++i )
+			manager.Free(blocks[i]);
+
+		delete [] blocks;
+	}
+}
+
+/*
+*	\brief
+*	Times the search for medium sized assets in pages fragmented by smaller ones,
+*	with the segregated free lists and with the granule bitmaps.
+*/
+void SearchBenchmark()
+{
+	const unsigned assets = 4096;
+	const METADATA_LAYOUT layouts[] = { LAYOUT_INLINE, LAYOUT_BITMAP };
+	const char* names[] = { "Free lists", "Bitmap" };
+
+	std::cout << "Search benchmark" << std::endl;
+
+	for ( unsigned l = 0; l < 2; ++l )
+	{
+		VariableMemoryManager manager(64 * MEM_SIZE::KILO_BYTE, 16, true, PAGE_SOURCE_HEAP, layouts[l]);
+
+		void** small = new void*[assets];
+		void** medium = new void*[assets];
+
+		// every other small asset is released, leaving holes too small for the medium ones
+		for ( unsigned i = 0; i < assets; ++i )
+			small[i] = manager.Allocate(64 + ( i % 8 ) * 32);
+
+		for ( unsigned i = 0; i < assets; i += 2 )
+			manager.Free(small[i]);
+
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+
+		for ( unsigned i = 0; i < assets; ++i )
+			medium[i] = manager.Allocate(512 + ( i % 4 ) * 256);
+
+		std::chrono::duration<double, std::nano> elapsed = BenchmarkClock::now() - start;
+
+		std::cout << names[l] << "\tns per Allocate : " << elapsed.count() / assets << std::endl;
+
+		for ( unsigned i = 0; i < assets; ++i )
+			manager.Free(medium[i]);
+
+		for ( unsigned i = 1; i < assets; i += 2 )
+			manager.Free(small[i]);
+
+		delete [] small;
+		delete [] medium;
+	}
+}
+
+/*
+*	\brief
+*	Work done by every thread of MultithreadedBenchmark. Blocks are allocated and freed 
+*	locally, except the first block of each round which is handed to the next thread 
+*	through a mailbox so remote frees are exercised as well.
+*/
+void MultithreadedWorker( ConcurrentMemoryManager* manager, std::atomic<void*>* mailboxes, 
+						  unsigned self, unsigned threads, unsigned rounds )
+{
+	void* blocks[64];
+
+	for ( unsigned round = 0; round < rounds; ++round )
+	{
+		for ( unsigned i = 0; i < 64; ++i )
+			blocks[i] = manager->Allocate(16 + ( i * 40 ) % 512);
+
+		// whatever is still waiting in the neighbour's mailbox was ours
+		void* unclaimed = mailboxes[( self + 1 ) % threads].exchange(blocks[0]);
+
+		if ( unclaimed )
+			manager->Free(unclaimed);
+
+		// and whatever waits in ours belongs to the previous thread
+		void* received = mailboxes[self].exchange(nullptr);
+
+		if ( received )
+			manager->Free(received);
+
+		for ( unsigned i = 1; i < 64; ++i )
+			manager->Free(blocks[i]);
+	}
+}
+
+/*
+*	\brief
+*	Measures the throughput of ConcurrentMemoryManager from 1 to 32 threads. 
+*	Every thread does the same amount of work, so ideal scaling keeps the time constant.
+*/
+void MultithreadedBenchmark()
+{
+	const unsigned rounds = 2000;
+
+	std::cout << "Multithreaded benchmark" << std::endl;
+
+	for ( unsigned threads = 1; threads <= 32; threads *= 2 )
+	{
+		ConcurrentMemoryManager manager(64 * MEM_SIZE::KILO_BYTE, 50);
+
+		std::vector<std::atomic<void*> > mailboxes(threads);
+		std::vector<std::thread> workers;
+
+		for ( unsigned i = 0; i < threads; ++i )
+			mailboxes[i] = nullptr;
+
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+
+		for ( unsigned i = 0; i < threads; ++i )
+			workers.push_back(std::thread(MultithreadedWorker, &manager, &mailboxes[0], i, threads, rounds));
+
+		for ( unsigned i = 0; i < threads; ++i )
+			workers[i].join();
+
+		std::chrono::duration<double> elapsed = BenchmarkClock::now() - start;
+
+		for ( unsigned i = 0; i < threads; ++i )
+		{
+			if ( mailboxes[i].load() )
+				manager.Free(mailboxes[i].load());
+		}
+
+		double operations = 2.0 * 64 * rounds * threads;
+
+		std::cout << "Threads : " << threads << "\tMillion operations per second : " << operations / elapsed.count() / 1000000.0 << std::endl;
+	}
+}
+
+/*
+*	\brief
+*	Run a single threaded workload on every allocator
+*/
+#define RUN_ON_EVERY_HEAP(name, workload, operations)												\
+	RunSingle<MallocHeap>(name, workload<MallocHeap>, operations);									\
+	RunSingle<VmmHeap<LAYOUT_INLINE> >(name, workload<VmmHeap<LAYOUT_INLINE> >, operations);			\
+	RunSingle<VmmHeap<LAYOUT_INLINE, BestFit> >(name, workload<VmmHeap<LAYOUT_INLINE, BestFit> >, operations);	\
+	RunSingle<VmmHeap<LAYOUT_INLINE, FirstFit> >(name, workload<VmmHeap<LAYOUT_INLINE, FirstFit> >, operations);	\
+	RunSingle<VmmHeap<LAYOUT_INLINE, NextFit> >(name, workload<VmmHeap<LAYOUT_INLINE, NextFit> >, operations);	\
+	RunSingle<VmmHeap<LAYOUT_BITMAP> >(name, workload<VmmHeap<LAYOUT_BITMAP> >, operations)
+
+int main( int argc, char** argv )
+{
+	unsigned operations = argc > 1 ? static_cast<unsigned>( atoi(argv[1]) ) : 1000000;
+	unsigned threads = argc > 2 ? static_cast<unsigned>( atoi(argv[2]) ) : 4;
+	std::string only = argc > 3 ? argv[3] : "";
+
+	if ( 0 == operations )
+		operations = 1000000;
+
+	if ( 0 == threads )
+		threads = 4;
+
+	std::cout << "Operations : " << operations << "\tThreads : " << threads << std::endl;
+	std::cout << "Workload\tAllocator\tMops/s\tp50 ns\tp99 ns\tp999 ns\tRSS KB\tPeak live KB\tFragmentation" << std::endl;
+
+	if ( only.empty() || "churn" == only )
+	{
+		RUN_ON_EVERY_HEAP("churn", RandomChurn, operations);
+	}
+
+	if ( only.empty() || "lifofifo" == only )
+	{
+		RUN_ON_EVERY_HEAP("lifofifo", LifoFifo, operations);
+	}
+
+	if ( only.empty() || "levels" == only )
+	{
+		RUN_ON_EVERY_HEAP("levels", AssetLevels, operations);
+	}
+
+	if ( only.empty() || "threads" == only )
+	{
+		RunThreaded<MallocHeap>("threads", operations, threads);
+		RunThreaded<ConcurrentHeap>("threads", operations, threads);
+	}
+
+	// how the VMM scales with the number of pages and threads
+	if ( only.empty() || "scaling" == only )
+	{
+		FreeLatencyBenchmark();
+		SearchBenchmark();
+		PageSelectionBenchmark();
+		MultithreadedBenchmark();
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 Xavier RX Tan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in the
+Software without restriction, including without limitation the rights to use, copy,
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the
+following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/****************************************************
+Author : Xavier Tan
+Email  : xavier.rx.tan@gmail.com / tan.ruixiang@digipen.edu
+
+AllocationTrace.cpp
+
+*****************************************************/
+
+#include "AllocationTrace.h"
+#include <cstring>
+
+// Description:
+// Constructor
+TraceWriter::TraceWriter( const char* fileName, TraceHeader header )
+	: file(fileName, std::ios::binary), start(std::chrono::steady_clock::now()), count(0)
+{
+	memcpy(header.magic, TraceMagic, sizeof(header.magic));
+	header.version = TRACE_FORMAT_VERSION;
+	header.recordSize = sizeof(TraceRecord);
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+// Description:
+// Destructor
+TraceWriter::~TraceWriter()
+{
+	Flush();
+	file.close();
+}
+
+// Description:
+// Whether the file could be opened
+bool TraceWriter::IsOpen() const
+{
+	return file.is_open();
+}
+
+// Description:
+// Fill in the next record, writing out the buffer when it is full
+void TraceWriter::Write( TRACE_OP op, const void* object, std::size_t size, unsigned alignment )
+{
+	TraceRecord& record = buffer[count];
+
+	record.object = reinterpret_cast<std::uintptr_t>(object);
+	record.time = static_cast<std::uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count() );
+	record.op = op;
+	record.alignment = 0;
+	record.size = size;
+
+	while ( alignment > 1 )
+	{
+		++record.alignment;
+		alignment >>= 1;
+	}
+
+	if ( ++count == TRACE_BUFFER_RECORDS )
+		Flush();
+}
+
+// Description:
+// Write out the buffered records
+void TraceWriter::Flush()
+{
+	file.write(reinterpret_cast<const char*>(buffer), static_cast<std::streamsize>( count * sizeof(TraceRecord) ));
+	count = 0;
+}
\ No newline at end of file
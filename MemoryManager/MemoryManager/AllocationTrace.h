@@ -0,0 +1,163 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 Xavier RX Tan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in the
+Software without restriction, including without limitation the rights to use, copy,
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the
+following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/****************************************************
+Author : Xavier Tan
+Email  : xavier.rx.tan@gmail.com / tan.ruixiang@digipen.edu
+
+AllocationTrace.h
+
+*****************************************************/
+#ifndef ALLOCATION_TRACE_H_
+#define ALLOCATION_TRACE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+
+/**
+	\file AllocationTrace.h
+	\brief
+		Binary format written by VariableMemoryManager::StartTrace. A trace is a TraceHeader 
+		followed by one TraceRecord per request, in the order the requests were made. Memory 
+		is identified by the address it had when captured, which is unique among live memory, 
+		so a replay ties every release back to its allocation. Fields are in the byte order 
+		of the machine that wrote the trace.
+*/
+
+/**
+	\brief
+		Identifies a trace file
+*/
+static const char TraceMagic[4] = { 'V', 'M', 'M', 'T' };
+
+/**
+	\enum TRACE_VERSION
+	\brief
+		Revision of the format, bumped whenever a record changes
+*/
+enum TRACE_VERSION
+{
+	TRACE_FORMAT_VERSION = 3
+};
+
+/**
+	\enum TRACE_OP
+	\brief
+		Request a record stands for
+*/
+enum TRACE_OP
+{
+	TRACE_ALLOCATE = 0,		/**< Allocate, AllocateBatch and AllocateAligned. object is the memory handed out*/
+	TRACE_FREE,				/**< Free and FreeBatch. object is the memory released*/
+	TRACE_REALLOCATE,		/**< Reallocate. object is the memory resized, always followed by a TRACE_REALLOCATED record*/
+	TRACE_REALLOCATED,		/**< object is where the memory of the preceding TRACE_REALLOCATE ended up*/
+	TRACE_RESET				/**< Reset, every memory is released. size is the number of pages kept*/
+};
+
+/**
+	\struct TraceHeader AllocationTrace.h
+	\brief
+		Start of a trace, the configuration of the manager it was captured from
+*/
+struct TraceHeader
+{
+	char		  magic[4];				/**< TraceMagic*/
+	std::uint32_t version;				/**< TRACE_FORMAT_VERSION*/
+	std::uint64_t pageSize;				/**< page size of the manager*/
+	std::uint64_t fragmentThreshold;	/**< fragment threshold of the manager*/
+	std::uint32_t layout;				/**< METADATA_LAYOUT of the manager*/
+	std::uint32_t recordSize;			/**< sizeof(TraceRecord)*/
+};
+
+/**
+	\struct TraceRecord AllocationTrace.h
+	\brief
+		A single request
+*/
+struct TraceRecord
+{
+	std::uint64_t object;				/**< address of the memory, ties records of the same memory together*/
+	std::uint64_t time		: 48;		/**< nanoseconds since the trace started*/
+	std::uint64_t op		: 8;		/**< TRACE_OP*/
+	std::uint64_t alignment : 8;		/**< log2 of the requested alignment, 0 for plain requests*/
+	std::uint64_t size;					/**< requested size*/
+};
+
+/**
+	\class TraceWriter AllocationTrace.h
+	\brief
+		Gathers records in a fixed buffer and writes them out a buffer at a time,
+		so tracing costs a clock read and a copy per request
+*/
+class TraceWriter
+{
+public:
+	/**
+		\brief Open the trace and write its header
+		\param fileName	Name of the output file
+		\param header	Configuration of the traced manager, the magic and version are filled in
+	*/
+	TraceWriter( const char* fileName, TraceHeader header );
+
+	/**
+		\brief Write out whatever is buffered and close the trace
+	*/
+	~TraceWriter();
+
+	/**
+		\brief Whether the file could be opened
+	*/
+	bool IsOpen() const;
+
+	/**
+		\brief Record a request
+		\param op			TRACE_OP
+		\param object		Memory the request is about
+		\param size			Requested size
+		\param alignment	Requested alignment, 0 for plain requests
+	*/
+	void Write( TRACE_OP op, const void* object, std::size_t size, unsigned alignment );
+
+private:
+
+	// Note: C++11 ctor disabling is not supported in MSVC11
+	TraceWriter(const TraceWriter& ) /*= delete*/;
+	TraceWriter& operator= ( const TraceWriter& ) /*= delete*/;
+
+	/**
+		\brief Write out the buffered records
+	*/
+	void Flush();
+
+	enum TRACE_BUFFER
+	{
+		TRACE_BUFFER_RECORDS = 4096		/**< records gathered before a write*/
+	};
+
+	std::ofstream file;										/**< the trace*/
+	std::chrono::steady_clock::time_point start;			/**< when the trace started*/
+	TraceRecord buffer[TRACE_BUFFER_RECORDS];				/**< records not written yet*/
+	unsigned	count;										/**< number of records in buffer*/
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,380 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 Xavier RX Tan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in the
+Software without restriction, including without limitation the rights to use, copy,
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the
+following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/****************************************************
+Author : Xavier Tan
+Email  : xavier.rx.tan@gmail.com / tan.ruixiang@digipen.edu
+
+ConcurrentMemoryManager.cpp
+
+*****************************************************/
+
+#include "ConcurrentMemoryManager.h"
+
+#include <algorithm>
+#include <cstring>
+
+// source of the unique manager ids, 0 is never handed out
+static std::atomic<unsigned> nextManagerId(1);
+
+// managers a thread finds its heap in without taking a lock
+enum HEAP_CACHE
+{
+	HEAP_CACHE_SIZE = 4
+};
+
+// per thread cache of the managers used last. Plain values so the
+// lookup on the allocation path is a few ordinary memory reads.
+static thread_local unsigned			   cachedManagerIds[HEAP_CACHE_SIZE] = {};
+static thread_local VariableMemoryManager* cachedHeaps[HEAP_CACHE_SIZE] = {};
+static thread_local unsigned			   cacheVictim = 0;
+
+// live managers, so an exiting thread only reaches managers that still exist
+static std::mutex							 registryLock;
+static std::vector<ConcurrentMemoryManager*> registry;
+
+// Description:
+// Constructor. Managers are created lazily as threads show up.
+ConcurrentMemoryManager::ConcurrentMemoryManager(const std::size_t& _pageSizeInBytes, const std::size_t& _fragmentThreshold,
+												 bool _allocateUponNoFreeSpace, unsigned _pageSourceFlags, METADATA_LAYOUT _layout)
+		: pageSize(_pageSizeInBytes), fragmentThreshold(_fragmentThreshold), bAllocate ( _allocateUponNoFreeSpace ), 
+		  pageSourceFlags ( _pageSourceFlags ), layout ( _layout )
+{
+	id = nextManagerId.fetch_add(1);
+
+	std::lock_guard<std::mutex> lock(registryLock);
+	registry.push_back(this);
+}
+
+// Description:
+// Destructor. Leaving the registry first waits for any exiting
+// thread that is still handing its manager back.
+ConcurrentMemoryManager::~ConcurrentMemoryManager()
+{
+	{
+		std::lock_guard<std::mutex> lock(registryLock);
+		registry.erase(std::find(registry.begin(), registry.end(), this));
+	}
+
+	for ( unsigned i = 0; i < heaps.size(); ++i )
+		delete heaps[i].heap;
+}
+
+// Description:
+// Runs on the exiting thread, for every manager it got a heap from
+// that is still alive.
+ConcurrentMemoryManager::ThreadExit::~ThreadExit()
+{
+	std::lock_guard<std::mutex> lock(registryLock);
+
+	for ( unsigned i = 0; i < managers.size(); ++i )
+	{
+		for ( unsigned j = 0; j < registry.size(); ++j )
+		{
+			if ( registry[j]->id == managers[i] )
+				registry[j]->ReleaseThreadHeap();
+		}
+	}
+
+	for ( unsigned i = 0; i < HEAP_CACHE_SIZE; ++i )
+		cachedManagerIds[i] = 0;
+}
+
+// Description:
+// Constructed on the first heap a thread gets, destroyed when it exits
+thread_local ConcurrentMemoryManager::ThreadExit ConcurrentMemoryManager::threadExit;
+
+// Description:
+// Take whatever other threads released back to this thread's
+// manager first, then allocate from it as usual.
+void* ConcurrentMemoryManager::Allocate( const std::size_t& size )
+{
+	VariableMemoryManager* heap = LocalHeap();
+
+	if ( heap->HasRemoteFrees() )
+		heap->ReclaimRemoteFrees();
+
+	return heap->Allocate(size);
+}
+
+// Description:
+// Batch counterpart of Allocate
+unsigned ConcurrentMemoryManager::AllocateBatch( const std::size_t& size, unsigned count, void** objects )
+{
+	VariableMemoryManager* heap = LocalHeap();
+
+	if ( heap->HasRemoteFrees() )
+		heap->ReclaimRemoteFrees();
+
+	return heap->AllocateBatch(size, count, objects);
+}
+
+// Description:
+// Aligned counterpart of Allocate
+void* ConcurrentMemoryManager::AllocateAligned( const std::size_t& size, const unsigned& alignment )
+{
+	VariableMemoryManager* heap = LocalHeap();
+
+	if ( heap->HasRemoteFrees() )
+		heap->ReclaimRemoteFrees();
+
+	return heap->AllocateAligned(size, alignment);
+}
+
+// Description:
+// Memory owned by the calling thread is resized by its own manager, which
+// may do so in place. Anything else has to move over to that manager, and
+// the boundary tags and bitmaps of the owner are not to be read for its size.
+void* ConcurrentMemoryManager::Reallocate( void* object, const std::size_t& size )
+{
+	if ( nullptr == object )
+		return Allocate(size);
+
+	if ( 0 == size )
+	{
+		Free(object);
+		return nullptr;
+	}
+
+	VariableMemoryManager* heap = LocalHeap();
+
+	if ( heap->HasRemoteFrees() )
+		heap->ReclaimRemoteFrees();
+
+	VariableMemoryManager* owner = heap->OwnerOf(object);
+
+	if ( owner == heap )
+		return heap->Reallocate(object, size);
+
+	std::size_t oldSize = owner->GetMappedSize(object);
+
+	if ( 0 == oldSize )
+		return nullptr;
+
+	return Reallocate(object, oldSize, size);
+}
+
+// Description:
+// The local manager knows the size of its own memory, the old size only
+// bounds the copy out of the memory of other threads
+void* ConcurrentMemoryManager::Reallocate( void* object, const std::size_t& oldSize, const std::size_t& size )
+{
+	if ( nullptr == object )
+		return Allocate(size);
+
+	if ( 0 == size )
+	{
+		Free(object);
+		return nullptr;
+	}
+
+	VariableMemoryManager* heap = LocalHeap();
+
+	if ( heap->HasRemoteFrees() )
+		heap->ReclaimRemoteFrees();
+
+	VariableMemoryManager* owner = heap->OwnerOf(object);
+
+	if ( owner == heap )
+		return heap->Reallocate(object, size);
+
+	void* moved = heap->Allocate(size);
+
+	if ( nullptr == moved )
+		return nullptr;
+
+	memcpy(moved, object, oldSize < size ? oldSize : size);
+	owner->FreeRemote(object);
+
+	return moved;
+}
+
+// Description:
+// The page header names the manager that handed out the memory.
+// Release it directly when that is the calling thread's own,
+// otherwise leave it on the owner's remote free stack.
+void ConcurrentMemoryManager::Free( void* object )
+{
+	VariableMemoryManager* heap = CachedHeap();
+	VariableMemoryManager* owner = ( heap ? heap : AnyHeap() )->OwnerOf(object);
+
+	if ( owner != heap )
+	{
+		owner->FreeRemote(object);
+		return;
+	}
+
+	// a thread that mostly frees drains its remote frees here as well
+	if ( heap->HasRemoteFrees() )
+		heap->ReclaimRemoteFrees();
+
+	heap->Free(object);
+}
+
+// Description:
+// Addresses of other threads are queued right away, the ones owned by
+// the calling thread are moved to the front and released together.
+void ConcurrentMemoryManager::FreeBatch( void** objects, unsigned count )
+{
+	if ( 0 == count )
+		return;
+
+	VariableMemoryManager* heap = CachedHeap();
+	VariableMemoryManager* reader = heap ? heap : AnyHeap();
+
+	unsigned local = 0;
+
+	for ( unsigned i = 0; i < count; ++i )
+	{
+		VariableMemoryManager* owner = reader->OwnerOf(objects[i]);
+
+		if ( owner == heap )
+			objects[local++] = objects[i];
+		else
+			owner->FreeRemote(objects[i]);
+	}
+
+	if ( 0 == local )
+		return;
+
+	if ( heap->HasRemoteFrees() )
+		heap->ReclaimRemoteFrees();
+
+	heap->FreeBatch(objects, local);
+}
+
+// Description:
+// Accessor
+unsigned ConcurrentMemoryManager::GetHeapCount()
+{
+	std::lock_guard<std::mutex> lock(heapLock);
+
+	return static_cast<unsigned>(heaps.size());
+}
+
+// Description:
+// Linear search of a few entries, the manager ids are never reused
+VariableMemoryManager* ConcurrentMemoryManager::CachedHeap() const
+{
+	for ( unsigned i = 0; i < HEAP_CACHE_SIZE; ++i )
+	{
+		if ( cachedManagerIds[i] == id )
+			return cachedHeaps[i];
+	}
+
+	return nullptr;
+}
+
+// Description:
+// Fast path is the thread local cache. On a miss the registry is searched
+// under the lock. A thread without a manager adopts the one an exited 
+// thread left behind, and only when there is none a manager is created.
+VariableMemoryManager* ConcurrentMemoryManager::LocalHeap()
+{
+	if ( VariableMemoryManager* cached = CachedHeap() )
+		return cached;
+
+	std::thread::id self = std::this_thread::get_id();
+	VariableMemoryManager* heap = nullptr;
+	bool created = false;
+
+	{
+		std::lock_guard<std::mutex> lock(heapLock);
+
+		for ( unsigned i = 0; i < heaps.size() && !heap; ++i )
+		{
+			if ( heaps[i].thread == self )
+				heap = heaps[i].heap;
+		}
+
+		for ( unsigned i = 0; i < heaps.size() && !heap; ++i )
+		{
+			if ( heaps[i].thread == std::thread::id() )
+			{
+				heaps[i].thread = self;
+				heap = heaps[i].heap;
+				created = true;
+			}
+		}
+
+		if ( !heap )
+		{
+			ThreadHeap entry;
+			entry.thread = self;
+			entry.heap = heap = new VariableMemoryManager(pageSize, fragmentThreshold, bAllocate, pageSourceFlags, layout);
+
+			heaps.push_back(entry);
+			created = true;
+		}
+	}
+
+	// the thread hands the manager back when it exits
+	if ( created )
+		threadExit.managers.push_back(id);
+
+	// whatever was freed into an adopted manager while it had no owner
+	if ( heap->HasRemoteFrees() )
+		heap->ReclaimRemoteFrees();
+
+	cachedManagerIds[cacheVictim] = id;
+	cachedHeaps[cacheVictim] = heap;
+	cacheVictim = ( cacheVictim + 1 ) % HEAP_CACHE_SIZE;
+
+	return heap;
+}
+
+// Description:
+// A thread that frees without ever having allocated from this manager
+// still needs a manager of the same page size to read page headers with.
+// Any will do, and when none exists yet the calling thread gets one.
+VariableMemoryManager* ConcurrentMemoryManager::AnyHeap()
+{
+	{
+		std::lock_guard<std::mutex> lock(heapLock);
+
+		if ( !heaps.empty() )
+			return heaps.front().heap;
+	}
+
+	return LocalHeap();
+}
+
+// Description:
+// Runs on the owning thread, so the manager can still be used without 
+// a lock. Remote frees queued after this wait for the adopting thread.
+void ConcurrentMemoryManager::ReleaseThreadHeap()
+{
+	std::thread::id self = std::this_thread::get_id();
+
+	std::lock_guard<std::mutex> lock(heapLock);
+
+	for ( unsigned i = 0; i < heaps.size(); ++i )
+	{
+		if ( heaps[i].thread != self )
+			continue;
+
+		heaps[i].heap->ReclaimRemoteFrees();
+		heaps[i].heap->ReturnUnusedMemory();
+
+		heaps[i].thread = std::thread::id();
+	}
+}
\ No newline at end of file
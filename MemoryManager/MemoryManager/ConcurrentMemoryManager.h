@@ -0,0 +1,198 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 Xavier RX Tan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in the
+Software without restriction, including without limitation the rights to use, copy,
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the
+following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/****************************************************
+Author : Xavier Tan
+Email  : xavier.rx.tan@gmail.com / tan.ruixiang@digipen.edu
+
+ConcurrentMemoryManager.h
+
+*****************************************************/
+#ifndef CONCURRENT_MEMORY_MANAGER_H_
+#define CONCURRENT_MEMORY_MANAGER_H_
+
+#include "MemoryManager.h"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+	\brief 
+		A thread safe front end over VariableMemoryManager. Every thread that allocates 
+		gets its own manager, and with it its own set of pages, so the allocation and 
+		local deallocation paths never take a lock nor touch an atomic read-modify-write. 
+		Memory released by a thread other than the one that allocated it is queued on 
+		the owner's lock-free remote free stack and reclaimed by the owner in batches.
+		The manager of a thread that exits is drained and left for the next thread 
+		that shows up, so churning threads does not grow the number of managers.
+*/
+class ConcurrentMemoryManager
+{
+private:
+	/**
+		\struct ThreadHeap ConcurrentMemoryManager.h
+		\brief
+			Associates a thread with the manager that serves it
+	*/
+	struct ThreadHeap
+	{
+		std::thread::id		   thread;	/**< The owning thread, a default constructed id once the thread exited*/
+		VariableMemoryManager* heap;	/**< The manager serving the thread*/
+	};
+
+	/**
+		\struct ThreadExit ConcurrentMemoryManager.h
+		\brief
+			One per thread, remembers the managers the thread got a heap from 
+			and hands those heaps back when the thread exits
+	*/
+	struct ThreadExit
+	{
+		std::vector<unsigned> managers;	/**< ids of the managers the thread has a heap in*/
+
+		~ThreadExit();
+	};
+
+public:
+	/**
+		\brief Constructor. The parameters are handed to the manager of every thread.
+		\param _pageSizeInBytes			Size of a chunk of memory for page management
+		\param _fragmentThreshold		A specified value to denote level of tolerance(in bytes) of the amount of fragmentation. Recommends the size of the smallest asset.
+		\param _allocateUponNoFreeSpace A switch that tells the manager to allocate a new page of memory of size pageSize
+		\param _pageSourceFlags			A combination of PAGE_SOURCE_FLAGS telling where page memory comes from
+		\param _layout					Where the managers track their regions
+	*/
+	ConcurrentMemoryManager( const std::size_t& _pageSizeInBytes, const std::size_t& _fragmentThreshold, 
+							 bool _allocateUponNoFreeSpace = true, unsigned _pageSourceFlags = PAGE_SOURCE_HEAP,
+							 METADATA_LAYOUT _layout = LAYOUT_INLINE );
+	/**
+		\brief Destructor. Releases the managers of every thread, including threads that already exited.
+	*/
+	~ConcurrentMemoryManager();
+
+	/**
+		\brief Thread safe. Allocate from the calling thread's manager
+		\param size	Size of the requested memory
+		\return A void pointer
+	*/
+	void*  Allocate		( const std::size_t& size );
+
+	/**
+		\brief Thread safe. Allocate many regions of the same size from the calling thread's manager
+		\param size	Size of every requested memory
+		\param count	Number of regions requested
+		\param objects	Receives count pointers
+		\return Number of regions allocated
+	*/
+	unsigned AllocateBatch( const std::size_t& size, unsigned count, void** objects );
+
+	/**
+		\brief Thread safe. Allocate from the calling thread's manager at a multiple of alignment
+		\param size		Size of the requested memory
+		\param alignment	Power of two the address must be a multiple of
+		\return A void pointer
+	*/
+	void*  AllocateAligned( const std::size_t& size, const unsigned& alignment );
+
+	/**
+		\brief Thread safe. Resize memory allocated by any thread. Memory of another thread 
+			   is moved into the calling thread's manager. Its size cannot be read while its 
+			   owner may be changing the page around it, so apart from large objects such memory 
+			   is left alone and nullptr returned. Pass the old size for it instead.
+		\param object	A pointer to the memory address to resize, nullptr behaves like Allocate
+		\param size	The new size, 0 behaves like Free
+		\return The address of the resized memory
+	*/
+	void*  Reallocate	( void* object, const std::size_t& size );
+
+	/**
+		\brief Thread safe. Resize memory allocated by any thread, whose size the caller knows. 
+			   Memory of another thread is moved into the calling thread's manager.
+		\param object	A pointer to the memory address to resize, nullptr behaves like Allocate
+		\param oldSize	The size the memory was last requested with, that many bytes at most are kept
+		\param size	The new size, 0 behaves like Free
+		\return The address of the resized memory
+	*/
+	void*  Reallocate	( void* object, const std::size_t& oldSize, const std::size_t& size );
+
+	/**
+		\brief Thread safe. Release memory allocated by any thread
+		\param object A pointer to the memory address that request deletion
+	*/
+	void   Free			( void* object );
+
+	/**
+		\brief Thread safe. Release many memory addresses at once. Addresses owned by the calling 
+			   thread are released as one batch, the others are queued for their owners.
+		\param objects	The memory addresses to release. The array is reordered.
+		\param count	Number of addresses
+	*/
+	void   FreeBatch	( void** objects, unsigned count );
+
+	/**
+		\brief Thread safe. Number of managers created so far, those of exited threads included
+	*/
+	unsigned GetHeapCount();
+
+private:
+
+	// Note: C++11 ctor disabling is not supported in MSVC11
+	ConcurrentMemoryManager() /*= delete*/;
+	ConcurrentMemoryManager(const ConcurrentMemoryManager& ) /*= delete*/;
+	ConcurrentMemoryManager& operator= ( const ConcurrentMemoryManager& ) /*= delete*/;
+
+	/**
+		\brief Find the calling thread's manager, creating it upon first use
+	*/
+	VariableMemoryManager* LocalHeap();
+
+	/**
+		\brief The calling thread's manager if the thread local cache knows it, nullptr otherwise
+	*/
+	VariableMemoryManager* CachedHeap() const;
+
+	/**
+		\brief Find any manager to read page headers with when the calling thread has none
+	*/
+	VariableMemoryManager* AnyHeap();
+
+	/**
+		\brief Called on the exiting thread. Drains the thread's manager and leaves it for another thread to adopt.
+	*/
+	void ReleaseThreadHeap();
+
+	std::size_t pageSize;			/**< size of a memory chunk that constitute a page*/
+	std::size_t fragmentThreshold;	/**< size of fragmentation tolerance*/
+	bool	 bAllocate;				/**< a switch to indicate if the managers request new pages when there is not enough to satisfy request*/
+	unsigned pageSourceFlags;		/**< where the managers get their page memory from*/
+	METADATA_LAYOUT layout;			/**< where the managers track their regions*/
+
+	unsigned id;					/**< unique id, lets the per thread cache tell managers apart even when one reuses the address of another*/
+
+	static thread_local ThreadExit threadExit; /**< hands the calling thread's managers back when it exits*/
+
+	std::mutex				heapLock; /**< guards heaps, only taken the first time a thread shows up*/
+	std::vector<ThreadHeap> heaps;	  /**< every manager created so far*/
+};
+
+#endif
\ No newline at end of file
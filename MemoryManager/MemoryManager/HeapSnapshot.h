@@ -0,0 +1,126 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 Xavier RX Tan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in the
+Software without restriction, including without limitation the rights to use, copy,
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the
+following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/****************************************************
+Author : Xavier Tan
+Email  : xavier.rx.tan@gmail.com / tan.ruixiang@digipen.edu
+
+HeapSnapshot.h
+
+*****************************************************/
+#ifndef HEAP_SNAPSHOT_H_
+#define HEAP_SNAPSHOT_H_
+
+#include <cstdint>
+
+/**
+	\file HeapSnapshot.h
+	\brief
+		Binary format written by VariableMemoryManager::MemoryDump. A snapshot is a
+		SnapshotHeader followed by pageCount pages. Every page is a SnapshotPage, its
+		regionCount SnapshotRegion records in address order and, when the snapshot was
+		taken with SNAPSHOT_CONTENTS, the pageSize bytes of its chunk. Fields are in
+		the byte order of the machine that wrote the snapshot.
+*/
+
+/**
+	\brief
+		Identifies a snapshot file
+*/
+static const char SnapshotMagic[4] = { 'V', 'M', 'M', 'S' };
+
+/**
+	\enum SNAPSHOT_VERSION
+	\brief
+		Revision of the format, bumped whenever a record changes
+*/
+enum SNAPSHOT_VERSION
+{
+	SNAPSHOT_FORMAT_VERSION = 3
+};
+
+/**
+	\enum SNAPSHOT_FLAGS
+	\brief
+		What a snapshot holds besides the block map
+*/
+enum SNAPSHOT_FLAGS
+{
+	SNAPSHOT_BLOCK_MAP = 0,			/**< regions only*/
+	SNAPSHOT_CONTENTS  = 1 << 0		/**< every page is followed by the bytes of its chunk*/
+};
+
+/**
+	\enum SNAPSHOT_REGION_FLAGS
+	\brief
+		State of a region
+*/
+enum SNAPSHOT_REGION_FLAGS
+{
+	SNAPSHOT_REGION_USED	  = 0,		/**< handed out*/
+	SNAPSHOT_REGION_AVAILABLE = 1 << 0,	/**< free*/
+	SNAPSHOT_REGION_SLAB	  = 1 << 1	/**< handed out as a slab of small slots*/
+};
+
+/**
+	\struct SnapshotHeader HeapSnapshot.h
+	\brief
+		Start of a snapshot
+*/
+struct SnapshotHeader
+{
+	char		  magic[4];			/**< SnapshotMagic*/
+	std::uint32_t version;			/**< SNAPSHOT_FORMAT_VERSION*/
+	std::uint32_t flags;			/**< SNAPSHOT_FLAGS*/
+	std::uint32_t layout;			/**< METADATA_LAYOUT of the manager*/
+	std::uint64_t pageSize;			/**< size of every chunk*/
+	std::uint64_t pageCount;		/**< number of pages that follow*/
+};
+
+/**
+	\struct SnapshotPage HeapSnapshot.h
+	\brief
+		Start of a page of a snapshot
+*/
+struct SnapshotPage
+{
+	std::uint64_t base;				/**< address of the chunk*/
+	std::uint64_t memLeft;			/**< free memory of the page as the manager counts it*/
+	std::uint32_t regionCount;		/**< number of SnapshotRegion records that follow*/
+	std::uint32_t reserved;			/**< 0, pads the record to 8 bytes*/
+};
+
+/**
+	\struct SnapshotRegion HeapSnapshot.h
+	\brief
+		A region of a page of a snapshot. Whatever lies between regions is
+		allocator meta data: the page header and, in LAYOUT_INLINE, boundary tags.
+*/
+struct SnapshotRegion
+{
+	std::uint64_t offset;			/**< where the memory of the region starts, from the chunk base*/
+	std::uint64_t size;				/**< size of the memory of the region*/
+	std::uint32_t flags;			/**< SNAPSHOT_REGION_FLAGS*/
+	std::uint32_t reserved;			/**< 0, pads the record to 8 bytes*/
+};
+
+#endif
\ No newline at end of file
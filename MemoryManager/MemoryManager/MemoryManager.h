@@ -30,7 +30,16 @@ VariableMemoryManager.h
 #ifndef MEMORY_MANAGER_H_
 #define MEMORY_MANAGER_H_
 
+#include "PageSource.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <vector>
+
+class TraceWriter;
 
 /**
 	\enum MEM_SIZE
@@ -44,28 +53,207 @@ enum MEM_SIZE
 	GIGA_BYTE = 1073741824
 };
 
+/**
+	\enum METADATA_LAYOUT
+	\brief 
+		Where a manager keeps track of the regions it hands out
+*/
+enum METADATA_LAYOUT
+{
+	LAYOUT_INLINE = 0,	/**< a boundary tag in front of every region, free lists threaded through the free regions*/
+	LAYOUT_BITMAP,		/**< regions are runs of granules tracked by bitmaps kept outside the chunk, so user memory holds no headers*/
+	LAYOUT_LINEAR		/**< an arena, regions are bumped off the pages in order and only released together by Rollback or Reset*/
+};
+
+/**
+	\struct ArenaMarker MemoryManager.h
+	\brief 
+		Position of a LAYOUT_LINEAR manager, see VariableMemoryManager::Mark. 
+		Only meant to be handed back to VariableMemoryManager::Rollback.
+*/
+struct ArenaMarker
+{
+	void*		page;						/**< page the arena was allocating from*/
+	std::size_t memLeft;					/**< memory left in that page*/
+	std::size_t bytesInUse;					/**< bytes in use of the manager*/
+	unsigned long long largeObjects;		/**< large objects allocated so far*/
+};
+
+/**
+	\struct MemoryStats MemoryManager.h
+	\brief 
+		Snapshot of the statistics of a manager, see VariableMemoryManager::GetStats. 
+		The counters cost a few increments per call and are always kept.
+*/
+struct MemoryStats
+{
+	unsigned long long allocations;			/**< memory handed out by Allocate, AllocateAligned and AllocateBatch*/
+	unsigned long long frees;				/**< memory released by Free and FreeBatch*/
+	unsigned long long reallocations;		/**< successful Reallocate calls on live memory*/
+	unsigned long long pageRequests;		/**< pages requested from the page source*/
+	unsigned long long pageReleases;		/**< pages given back by ReturnUnusedMemory*/
+
+	std::size_t bytesInUse;					/**< usable size of all live memory*/
+	std::size_t peakBytesInUse;				/**< highest bytesInUse since construction or ResetStats*/
+	std::size_t bytesFree;					/**< free memory left in all pages*/
+	std::size_t largestFreeBlock;			/**< largest memory a single request can get without a new page*/
+	double		externalFragmentation;		/**< 1 - largestFreeBlock / bytesFree, 0 when nothing is free*/
+
+	std::size_t pageCount;					/**< pages held*/
+	std::size_t emptyPageCount;				/**< pages without any live allocation*/
+
+	unsigned long long largeObjectMaps;		/**< mappings made for requests too large for a page*/
+	unsigned long long largeObjectFailures;	/**< requests too large for a page that no mapping could be made for*/
+	unsigned	largeObjectCount;			/**< live requests too large for a page*/
+	std::size_t largeObjectBytes;			/**< memory mapped for the live requests too large for a page*/
+
+	unsigned long long sizeClasses[sizeof(std::size_t) * 8]; /**< allocations per power of two of the requested size, bucket i counts sizes in [2^i, 2^(i+1))*/
+	unsigned long long allocateCycles[32];	/**< MEMORY_MANAGER_LATENCY_STATS only, Allocate calls per power of two of the cycles they took*/
+	unsigned long long freeCycles[32];		/**< MEMORY_MANAGER_LATENCY_STATS only, Free calls per power of two of the cycles they took*/
+};
+
+/**
+	\struct WorstFit MemoryManager.h
+	\brief 
+		Placement policy of a manager, see BasicVariableMemoryManager. Takes the 
+		largest free region of the first page that can hold the request, which 
+		keeps the remainder of the region large. This is the default.
+*/
+struct WorstFit
+{
+	enum FIT_TRAITS
+	{
+		SMALLEST_CLASS		= 0,	/**< take the smallest size class that holds the request rather than the largest*/
+		OWN_CLASS_FIRST		= 0,	/**< try the head of the request's own size class before rounding the request up*/
+		RESUME_AT_LAST_PAGE	= 0		/**< start looking for a page at the one the last region came from rather than the first*/
+	};
+
+	static const char* Name() { return "WorstFit"; }
+};
+
+/**
+	\struct BestFit MemoryManager.h
+	\brief 
+		Placement policy taking the smallest size class of the first page that 
+		is sure to hold the request, which keeps the large regions for large requests.
+*/
+struct BestFit
+{
+	enum FIT_TRAITS
+	{
+		SMALLEST_CLASS		= 1,
+		OWN_CLASS_FIRST		= 0,
+		RESUME_AT_LAST_PAGE	= 0
+	};
+
+	static const char* Name() { return "BestFit"; }
+};
+
+/**
+	\struct FirstFit MemoryManager.h
+	\brief 
+		Placement policy taking the first region found that holds the request, 
+		starting with the head of the request's own size class, then the smallest 
+		class above it. The closest the size classes get to an address ordered search.
+*/
+struct FirstFit
+{
+	enum FIT_TRAITS
+	{
+		SMALLEST_CLASS		= 1,
+		OWN_CLASS_FIRST		= 1,
+		RESUME_AT_LAST_PAGE	= 0
+	};
+
+	static const char* Name() { return "FirstFit"; }
+};
+
+/**
+	\struct NextFit MemoryManager.h
+	\brief 
+		Placement policy resuming the page search where the last region came from 
+		and wrapping around, so allocations spread over the pages in turn. 
+		Regions are picked within a page like WorstFit does.
+*/
+struct NextFit
+{
+	enum FIT_TRAITS
+	{
+		SMALLEST_CLASS		= 0,
+		OWN_CLASS_FIRST		= 0,
+		RESUME_AT_LAST_PAGE	= 1
+	};
+
+	static const char* Name() { return "NextFit"; }
+};
+
 /**
 	\brief 
 		A custom lightweight memory manager to help the user in maximizing 
 		memory usage for asset allocation in run time. Variable here refers 
 		to non-fixed allocation since game assets are not fixed size.
+
+		Both policies are resolved at compile time, so the branches that do not 
+		apply are folded away.
+	\tparam FitPolicy			How a free region is picked, WorstFit, BestFit, FirstFit or NextFit.
+								Only used by LAYOUT_INLINE, the other layouts keep their own placement.
+	\tparam PageSourcePolicy	Where chunks come from. Needs a constructor taking PAGE_SOURCE_FLAGS 
+								and the Acquire, Release, Decommit and Mode members of PageSource.
+								Requests too large for a page are always mapped by a PageSource.
 */
-class VariableMemoryManager
+template <class FitPolicy = WorstFit, class PageSourcePolicy = PageSource>
+class BasicVariableMemoryManager
 {
 private:
 	/**
 		\struct MetaData MemoryManager.h
 		\brief	
-			A meta data header to specify attribute of an associated memory region
+			A single word boundary tag in front of every memory region. Regions
+			lie back to back, so the next one starts right after the memory of
+			this one, and a free region repeats its size in its last word so the
+			region following it can find its start.
 	*/
 	struct MetaData	
 	{
-		unsigned  Size;				 /**< Size of associated memory */
-		MetaData* Next;				 /**< Pointer to next Meta Data Header*/
-		MetaData* Prev;				 /**< Pointer to previous Meta Data Header*/
-		unsigned short pageIndex;	 /**< Numeric index of associated parent page*/
-		bool available;				 /**< Availability boolean*/
-		char padding;				 /**< Padding byte for alignment*/
+		std::size_t Size : sizeof(std::size_t) * 8 - 3;	 /**< Size of associated memory */
+		std::size_t available : 1;						 /**< Availability flag*/
+		std::size_t prevAvailable : 1;					 /**< Availability flag of the region right before this one*/
+		std::size_t movable : 1;						 /**< Set on used regions handed out by AllocateHandle, which Compact may move*/
+	};
+
+	/**
+		\struct FreeLinks MemoryManager.h
+		\brief
+			Segregated free list links. Only valid while the associated memory
+			region is available, they live in the first bytes of the region itself
+			so no extra header space is spent on them.
+	*/
+	struct FreeLinks
+	{
+		MetaData* NextFree;			 /**< Next free region in the same size class*/
+		MetaData* PrevFree;			 /**< Previous free region in the same size class*/
+	};
+
+	/**
+		\brief
+			Smallest memory a region may hold, enough for its free list links 
+			and the trailing size word once it is released.
+	*/
+	enum BLOCK_SIZE
+	{
+		MIN_BLOCK_SIZE = sizeof(FreeLinks) + sizeof(std::size_t)
+	};
+
+	/**
+		\brief
+			Size class layout of the segregated free lists. First level classes
+			are powers of two, each split linearly into SL_COUNT second level classes.
+	*/
+	enum SIZE_CLASS
+	{
+		SL_LOG2  = 2,				 /**< log2 of the number of second level classes*/
+		SL_COUNT = 1 << SL_LOG2,	 /**< number of second level classes per first level class*/
+		FL_COUNT = sizeof(std::size_t) * 8 /**< number of first level classes, one per bit of a size*/
 	};
 
 	/**
@@ -76,31 +264,224 @@ private:
 	struct Page
 	{
 		Page*    Next;				/**< Pointer to next memory page*/
-		unsigned memLeft;			/**< Amount of memory left in this page*/
+		std::size_t slot;			/**< Leaf of the page in the page index, which is its position in the page list*/
+		std::size_t memLeft;		/**< Amount of memory left in this page*/
 		char*	 chunk;				/**< The memory chunk*/
-		unsigned short index;		/**< Numeric index of this memory page*/
+
+		std::size_t flBitmap;					 /**< Bit i is set when first level class i holds a free region*/
+		unsigned  slBitmap[FL_COUNT];			 /**< Per first level class, bit j is set when second level class j holds a free region*/
+		MetaData* freeLists[FL_COUNT][SL_COUNT]; /**< Heads of the segregated free lists*/
+
+		unsigned char* slabMap;		/**< Bit i is set when the i-th slabSize long stretch of the chunk is a slab, nullptr until the page holds one*/
+
+		unsigned* usedMap;			/**< LAYOUT_BITMAP only, bit i is set while granule i of the chunk is handed out*/
+		unsigned* endMap;			/**< LAYOUT_BITMAP only, bit i is set when granule i is the last one of a region*/
+		std::size_t longestRun;		/**< LAYOUT_BITMAP only, no run of free granules in the page is longer than this*/
+	};
+
+	/**
+		\brief
+			Unit of memory of the LAYOUT_BITMAP layout
+	*/
+	enum GRANULE
+	{
+		GRANULE_SIZE = 16,			/**< every region of the bitmap layout is a whole number of granules, aligned to one*/
+		GRANULE_BITS = 32			/**< granules covered by one word of a granule bitmap*/
+	};
+
+	/**
+		\struct Slab MemoryManager.h
+		\brief
+			Header of a slab, a region aligned to slabSize that is cut into headerless 
+			slots of a single small size. The region is slabBytes long, which leaves room 
+			for the boundary tag of the next region within slabSize, so the next slab 
+			carved starts right at the following slabSize boundary.
+	*/
+	struct Slab
+	{
+		Slab*	 Next;				/**< Next slab of the same size class with a free slot*/
+		Slab*	 Prev;				/**< Previous slab of the same size class with a free slot*/
+		void*	 freeSlots;			/**< Intrusive list of released slots*/
+		char*	 unused;			/**< Start of the slots never handed out yet*/
+		unsigned slotSize;			/**< Size of every slot*/
+		unsigned liveSlots;			/**< Number of slots handed out*/
+	};
+
+	/**
+		\brief
+			Slab size classes, one per pointer sized step up to the largest slot size
+	*/
+	enum SLAB_CLASS
+	{
+		SLAB_MAX_SLOT_SIZE = 256,		/**< largest request the slabs may serve*/
+		SLAB_MAX_SIZE	   = 16384,		/**< upper bound of the slab size*/
+		SLAB_PAGE_FRACTION = 16			/**< a slab is kept to this fraction of a page when possible, the stretch in front of the first aligned slab is no slab material*/
+	};
+
+	/**
+		\brief
+			Tuning of the adaptive fragment threshold
+	*/
+	enum ADAPTIVE_THRESHOLD
+	{
+		ADAPTIVE_UPDATE_INTERVAL = 256,		/**< requests between two updates of the thresholds*/
+		ADAPTIVE_HISTORY		 = 65536,	/**< requests the histogram remembers, older ones fade out as it is halved*/
+		ADAPTIVE_REUSE_SHARE	 = 16		/**< headroom is worth splitting off when at least 1 in this many requests fit in it*/
+	};
+
+	/**
+		\struct PageHeader MemoryManager.h
+		\brief
+			Stored at the start of every chunk. Chunks are aligned to pageAlignment,
+			so the page owning any address handed out is found by masking the address.
+	*/
+	struct PageHeader
+	{
+		Page* owner;						/**< The page that manages this chunk*/
+		BasicVariableMemoryManager* manager; /**< The manager the page belongs to*/
+	};
+
+	/**
+		\struct LargeObject MemoryManager.h
+		\brief
+			Header of a request too large for a page, which gets a mapping of its own. The mapping 
+			starts with a PageHeader without owner, so the memory handed out leads to it the same 
+			way memory in a page leads to its page.
+	*/
+	struct LargeObject
+	{
+		LargeObject* Next;			/**< Next large object, allocated earlier*/
+		LargeObject* Prev;			/**< Previous large object, allocated later*/
+		std::size_t	 length;		/**< Length of the mapping*/
+		std::size_t	 usable;		/**< Bytes from the memory handed out to the end of the mapping*/
+		unsigned long long serial;	/**< Order of allocation, tells Rollback which ones came after a marker*/
+	};
+
+	/**
+		\struct RemoteFree MemoryManager.h
+		\brief
+			Node of the remote free stack, stored in the first bytes of the memory
+			region that another thread released.
+	*/
+	struct RemoteFree
+	{
+		RemoteFree* Next;			/**< Next memory region waiting to be reclaimed*/
+	};
+
+	/**
+		\struct HandleEntry MemoryManager.h
+		\brief
+			Slot of the handle table. A region handed out by AllocateHandle keeps the
+			index of its slot in its first word, so a region that moves can update it.
+	*/
+	struct HandleEntry
+	{
+		void*	 object;			/**< Memory the handle refers to, past the index word*/
+		unsigned pins;				/**< Pin calls not matched by Unpin yet, the memory stays put while not 0*/
+		std::size_t nextFree;		/**< While the slot is unused, the next unused slot plus one, 0 ending the list*/
+	};
+
+	/**
+		\brief
+			Growth of the handle table
+	*/
+	enum HANDLE_TABLE
+	{
+		HANDLE_TABLE_INITIAL = 64	/**< slots of the table once the first handle is allocated, doubled whenever it runs full*/
+	};
+
+	/**
+		\brief
+			Time keeping of Compact
+	*/
+	enum COMPACT_CLOCK
+	{
+		COMPACT_CLOCK_INTERVAL = 32	/**< regions walked between two reads of the clock*/
 	};
 
 public:
+	/**
+		\brief Refers to memory handed out by AllocateHandle, which Compact may move
+	*/
+	typedef std::size_t Handle;
+
+	/**
+		\brief
+			Handle values with a special meaning
+	*/
+	enum HANDLE_VALUE
+	{
+		INVALID_HANDLE = 0			/**< returned when AllocateHandle fails, never refers to memory*/
+	};
+
 	/**
 		\brief Constructor.
 		\param _pageSizeInBytes			Size of a chunk of memory for page management
 		\param _fragmentThreshold		A specified value to denote level of tolerance(in bytes) of the amount of fragmentation. Recommends the size of the smallest asset.
 		\param _allocateUponNoFreeSpace A switch that tells the manager to allocate a new page of memory of size pageSize
+		\param _pageSourceFlags			A combination of PAGE_SOURCE_FLAGS telling where page memory comes from
+		\param _layout					Where the regions are tracked. LAYOUT_BITMAP ignores the fragment threshold, regions are rounded to whole granules instead, and so does LAYOUT_LINEAR.
 	*/
-	VariableMemoryManager( const unsigned& _pageSizeInBytes, const unsigned& _fragmentThreshold, 
-						   bool _allocateUponNoFreeSpace = true );
+	BasicVariableMemoryManager( const std::size_t& _pageSizeInBytes, const std::size_t& _fragmentThreshold, 
+								bool _allocateUponNoFreeSpace = true, unsigned _pageSourceFlags = PAGE_SOURCE_HEAP,
+								METADATA_LAYOUT _layout = LAYOUT_INLINE );
 	/**
 		\brief Destructor
 	*/
-	~VariableMemoryManager();
+	~BasicVariableMemoryManager();
 
 	/**
-		\brief Return a pointer location in an arbitrary memory chunk that satisfy the user's request
+		\brief Return a pointer location in an arbitrary memory chunk that satisfy the user's request. 
+			   Requests that do not fit in a page get a mapping of their own, which Free unmaps.
 		\param size	Size of the requested memory
 		\return A void pointer
 	*/
-	void*  Allocate		( const unsigned& size );
+	void*  Allocate		( const std::size_t& size );
+
+	/**
+		\brief Allocate many regions of the same size at once. Regions are carved back to back 
+			   out of as few free regions as possible, one search per page worth of regions.
+		\param size	Size of every requested memory
+		\param count	Number of regions requested
+		\param objects	Receives count pointers
+		\return Number of regions allocated, count unless a region too large for a page could not be mapped
+	*/
+	unsigned AllocateBatch( const std::size_t& size, unsigned count, void** objects );
+
+	/**
+		\brief Return a pointer location that is a multiple of alignment. It is released with Free like any other.
+		\param size		Size of the requested memory
+		\param alignment	Power of two the address must be a multiple of, e.g. 32 or 64 for SIMD data
+		\return A void pointer
+	*/
+	void*  AllocateAligned( const std::size_t& size, const unsigned& alignment );
+
+	/**
+		\brief Resize the memory at a specified address, in place whenever possible. When the memory 
+			   has to move, its content is copied and the old address released. Memory from 
+			   AllocateAligned keeps its alignment only as long as it is resized in place.
+		\param object	A pointer to the memory address to resize, nullptr behaves like Allocate
+		\param size	The new size, 0 behaves like Free
+		\return The address of the resized memory, nullptr if it could not be satisfied, in which case object is left untouched
+	*/
+	void*  Reallocate	( void* object, const std::size_t& size );
+
+	/**
+		\brief Usable size of the memory at a specified address, which may exceed the size requested. 
+			   LAYOUT_LINEAR keeps no sizes, the memory up to the end of what its page handed out is 
+			   reported instead, which is exact for the latest allocation.
+		\param object A pointer to a memory address handed out by this manager
+	*/
+	std::size_t GetAllocationSize( void* object ) const;
+
+	/**
+		\brief Thread safe. Usable size of the memory at a specified address, read only from what stays 
+			   put while the memory is live. Only large objects keep their size apart from the boundary 
+			   tags and bitmaps the owner rewrites as it frees the neighbours.
+		\param object A pointer to a memory address handed out by this manager
+		\return The usable size, 0 when the memory is not a large object
+	*/
+	std::size_t GetMappedSize( void* object ) const;
 
 	/**
 		\brief "Deallocate" a specified memory address by changing the availability flag to true and coalesce with neighboring free space
@@ -108,21 +489,364 @@ public:
 	*/
 	void   Free			( void* object );
 
-	// TODO: void   ReturnUnusedMemory();
+	/**
+		\brief Release many memory addresses at once, coalescing neighbouring addresses in a single pass
+		\param objects	The memory addresses to release. The array is sorted in place.
+		\param count	Number of addresses
+	*/
+	void   FreeBatch	( void** objects, unsigned count );
+
+	/**
+		\brief Allocate memory that the manager is allowed to move to fight fragmentation, see Compact. 
+			   The memory is reached through Resolve, and stays put while pinned.
+		\param size	Size of the requested memory
+		\return A handle to the memory, INVALID_HANDLE if it could not be satisfied
+	*/
+	Handle AllocateHandle( const std::size_t& size );
+
+	/**
+		\brief Current address of the memory of a handle. It is only valid until the next 
+			   Compact, unless the handle is pinned.
+		\param handle A handle from AllocateHandle
+		\return The memory, nullptr for INVALID_HANDLE
+	*/
+	void*  Resolve		( Handle handle ) const;
+
+	/**
+		\brief Keep the memory of a handle where it is until a matching Unpin. Pins nest.
+		\param handle A handle from AllocateHandle
+		\return The memory, which holds still while pinned, nullptr for INVALID_HANDLE
+	*/
+	void*  Pin			( Handle handle );
+
+	/**
+		\brief Undo one Pin of a handle
+		\param handle A pinned handle, INVALID_HANDLE is ignored
+	*/
+	void   Unpin		( Handle handle );
+
+	/**
+		\brief Release the memory of a handle, pinned or not. The handle may be handed out again.
+		\param handle A handle from AllocateHandle, INVALID_HANDLE is ignored
+	*/
+	void   FreeHandle	( Handle handle );
+
+	/**
+		\brief Move unpinned handle memory for a bounded amount of time. Within a page, handle 
+			   memory slides down over the free regions in front of it so the free memory 
+			   merges at the end of the page. Then the emptiest pages whose live memory all 
+			   belongs to unpinned handles are emptied into the other pages, so that 
+			   ReturnUnusedMemory or the trim policy can give them back. Each call picks up 
+			   where the previous one ran out of time, so it may be run in the slack of a frame. 
+			   Only LAYOUT_INLINE moves memory.
+		\param budgetMicroseconds Time the call may take. The region being moved when it runs out is finished first.
+		\return Number of bytes moved
+	*/
+	std::size_t Compact ( unsigned budgetMicroseconds );
+
+	/**
+		\brief LAYOUT_LINEAR only. Remember the position of the arena to roll back to
+		\return The position, which stays valid until the arena is rolled back past it
+	*/
+	ArenaMarker Mark() const;
+
+	/**
+		\brief LAYOUT_LINEAR only. Release everything allocated since a marker at once. Only the 
+			   pages allocated from since then are touched, their memory is served again right away.
+		\param marker A position returned by Mark
+	*/
+	void   Rollback		( const ArenaMarker& marker );
+
+	/**
+		\brief Thread safe, lock-free. Queue a memory address handed out by this manager for release 
+			   by the thread that owns the manager. The memory is reclaimed on the next ReclaimRemoteFrees.
+		\param object A pointer to the memory address that request deletion
+	*/
+	void   FreeRemote	( void* object );
+
+	/**
+		\brief Release every memory address queued by FreeRemote in one batch. Owning thread only.
+	*/
+	void   ReclaimRemoteFrees();
+
+	/**
+		\brief Thread safe. Check whether FreeRemote queued memory since the last ReclaimRemoteFrees
+	*/
+	bool   HasRemoteFrees() const;
+
+	/**
+		\brief Find the manager that handed out a memory address.
+		\param object A memory address handed out by this manager or any other manager of the same page size
+		\return The owning manager
+	*/
+	BasicVariableMemoryManager* OwnerOf( void* object ) const;
+
+	/**
+		\brief Serve requests up to maxSlotSize bytes from slabs. Small objects then cost no header 
+			   and no search, a slot is popped off the free list of its size class instead. 
+			   The slabs themselves are regular regions of this manager.
+		\param maxSlotSize Largest request served by the slabs, at most SLAB_MAX_SLOT_SIZE. 0 turns slabs off for new requests.
+	*/
+	void SetSlabLimit( unsigned maxSlotSize );
+
+	/**
+		\brief Let the fragment threshold follow the sizes requested. A histogram of the recent 
+			   request sizes is kept, and the headroom of a request is only split off when at 
+			   least 1 in ADAPTIVE_REUSE_SHARE requests, or another request of the same power of 
+			   two, would fit in it. Smaller headroom would be left over as an unusable sliver, 
+			   so it stays with the request. The threshold given upon construction applies 
+			   until the first ADAPTIVE_UPDATE_INTERVAL requests have been seen.
+		\param enable Whether the threshold adapts, false goes back to the threshold given upon construction
+	*/
+	void SetAdaptiveThreshold( bool enable );
+
+	/**
+		\brief Fragment threshold currently applied to requests of a given size
+		\param size Size of the request
+		\return Largest headroom, in bytes, that is handed out along with the request rather than split off
+	*/
+	std::size_t GetFragmentThreshold( std::size_t size ) const;
+
+	/**
+		\brief Give pages that hold no live allocation back to the system. Pages are found
+			   through the owning page header, so nothing needs renumbering afterwards.
+		\param pagesToKeep Number of empty pages to hold on to for future allocations
+		\return Number of pages released
+	*/
+	std::size_t ReturnUnusedMemory( std::size_t pagesToKeep = 0 );
+
+	/**
+		\brief Release every allocation at once, which unloading a level would otherwise take a 
+			   Free per allocation for. Each page is turned back into a single free region without 
+			   visiting its regions, and the pages stay with the manager for the next allocations. 
+			   Handles, slabs and memory queued by FreeRemote are dropped along with them.
+		\param pagesToKeep Number of pages that stay committed. The memory of the others is decommitted 
+							when the page source maps its chunks, otherwise the pages are returned.
+	*/
+	void Reset( std::size_t pagesToKeep = ~static_cast<std::size_t>(0) );
+
+	/**
+		\brief Let Free trim empty pages on its own. Once more than highWaterPages pages are
+			   empty, the empty pages beyond lowWaterPages are returned to the system.
+		\param highWaterPages Number of empty pages tolerated before trimming
+		\param lowWaterPages  Number of empty pages kept when trimming, at most highWaterPages
+	*/
+	void SetTrimPolicy( std::size_t highWaterPages, std::size_t lowWaterPages );
+
+	/**
+		\brief Disable automatic trimming inside Free. This is the default.
+	*/
+	void DisableTrimPolicy();
+
+	/**
+		\brief Report the backing the page memory actually got, which may be weaker than
+			   what was asked for if huge pages were not available.
+	*/
+	PAGE_SOURCE_MODE GetPageSourceMode() const;
+
+	/**
+		\brief Accessor
+	*/
+	METADATA_LAYOUT GetLayout() const;
+
+	/**
+		\brief Gather the statistics of the manager. The counters are read as they are, 
+			   the free memory figures walk the pages.
+	*/
+	MemoryStats GetStats() const;
+
+	/**
+		\brief Start a new statistics window. Counters and histograms restart from 0, 
+			   the peak restarts from the bytes in use.
+	*/
+	void ResetStats();
+
+	/**
+		\brief Report the memory left in every page, in page order
+		\param memLeft	Receives the memory left of up to maxPages pages
+		\param maxPages	Size of memLeft
+		\return Number of pages held, which may exceed maxPages
+	*/
+	std::size_t GetPageMemLeft( std::size_t* memLeft, std::size_t maxPages ) const;
+
+	/**
+		\brief Write a binary snapshot of the pages for offline examination, see HeapSnapshot.h 
+			   for the format and SnapshotTool for reports. The snapshot is gathered in memory 
+			   and written in a single call.
+		\param fileName		Name of the output file
+		\param withContents	Append the bytes of every chunk to the block map
+	*/
+	void MemoryDump (const char* fileName, bool withContents = false);
 
 	/**
-		\brief A debug function to dump a text file for examination of memory allocated.
-		\param fileName Name of the output file
+		\brief Record every request from now on to a binary trace, see AllocationTrace.h for the 
+			   format and TraceReplay to replay it against other configurations. A trace that is 
+			   already running is stopped first.
+		\param fileName	Name of the output file
+		\return Whether the file could be opened
 	*/
-	void MemoryDump (const char* fileName);
+	bool StartTrace( const char* fileName );
+
+	/**
+		\brief Write out and close the running trace, if any
+	*/
+	void StopTrace();
 
 private:
 
 	// Note: C++11 ctor disabling is not supported in MSVC11
-	VariableMemoryManager() /*= delete*/;
-	VariableMemoryManager(const VariableMemoryManager& ) /*= delete*/;
-	VariableMemoryManager(VariableMemoryManager&& ) /*= delete*/;
-	VariableMemoryManager& operator= ( const VariableMemoryManager& ) /*= delete*/;
+	BasicVariableMemoryManager() /*= delete*/;
+	BasicVariableMemoryManager(const BasicVariableMemoryManager& ) /*= delete*/;
+	BasicVariableMemoryManager(BasicVariableMemoryManager&& ) /*= delete*/;
+	BasicVariableMemoryManager& operator= ( const BasicVariableMemoryManager& ) /*= delete*/;
+
+	/**
+		\brief Allocate without counting, used by Allocate and internally
+	*/
+	void* AllocateObject( std::size_t size );
+
+	/**
+		\brief AllocateBatch without counting
+	*/
+	unsigned AllocateBatchObjects( std::size_t size, unsigned count, void** objects );
+
+	/**
+		\brief AllocateAligned without counting, used by AllocateAligned and for slabs
+	*/
+	void* AllocateAlignedObject( std::size_t size, unsigned alignment );
+
+	/**
+		\brief Reallocate of live memory to a size other than 0, without counting
+	*/
+	void* ReallocateObject( void* object, std::size_t size );
+
+	/**
+		\brief Free without counting, used by Free and internally
+	*/
+	void FreeObject( void* object );
+
+	/**
+		\brief Count memory handed out to the user, and trace the request
+	*/
+	void RecordAllocation( void* object, std::size_t size, unsigned alignment );
+
+	/**
+		\brief Count memory released by the user, before it is released, and trace the request
+	*/
+	void RecordFree( void* object );
+
+	/**
+		\brief Count a request in the histogram of the adaptive threshold
+	*/
+	void SampleRequest( std::size_t size );
+
+	/**
+		\brief Derive the fragment threshold of every power of two from the histogram
+	*/
+	void UpdateThresholds();
+
+	/**
+		\brief Fragment threshold of a request already rounded by RoundRequest
+	*/
+	std::size_t FragmentThreshold( std::size_t request ) const;
+
+	/**
+		\brief Take an unused slot of the handle table, growing it when there is none
+		\param object	Memory of the handle, past the index word
+		\return The handle
+	*/
+	Handle NewHandle( void* object );
+
+	/**
+		\brief Slot of the handle table behind a handle
+	*/
+	HandleEntry& EntryOf( Handle handle ) const;
+
+	/**
+		\brief Whether Compact may move a used region right now
+	*/
+	bool IsMovable( MetaData* block ) const;
+
+	/**
+		\brief Point the handle of a region that moved at its new memory, and trace the move
+		\param from	Former memory of the region
+		\param block	The region at its new place
+	*/
+	void Relocated( void* from, MetaData* block );
+
+	/**
+		\brief Move the used region right after a free region down to the start of the free region. 
+			   The free memory ends up behind the moved region, merged with the region after it.
+		\param p		The page the regions reside in
+		\param hole	The free region, already removed from the free lists
+		\param block	The movable region right after hole
+		\return The free region now following the moved region, not in the free lists
+	*/
+	MetaData* SlideDown( Page* p, MetaData* hole, MetaData* block );
+
+	/**
+		\brief Slide the movable regions of a page down over the free regions in front of them
+		\param p			The page to compact
+		\param deadline	Time at which to give up
+		\param moved		Incremented by the bytes moved
+		\return Whether the whole page was compacted before the deadline
+	*/
+	bool SlidePage( Page* p, std::chrono::steady_clock::time_point deadline, std::size_t& moved );
+
+	/**
+		\brief The page with the most memory left, short of empty, that holds only movable regions
+		\param deadline	Time at which to give up
+		\return The page, nullptr when no page is at most half full or the deadline passed
+	*/
+	Page* SparsestMovablePage( std::chrono::steady_clock::time_point deadline ) const;
+
+	/**
+		\brief Move the regions of a page into the other pages that have room
+		\param p			The page to empty
+		\param deadline	Time at which to give up
+		\param moved		Incremented by the bytes moved
+		\return Whether the page was emptied
+	*/
+	bool EvacuatePage( Page* p, std::chrono::steady_clock::time_point deadline, std::size_t& moved );
+
+	/**
+		\brief Size of the largest free region of a page
+	*/
+	std::size_t LargestFreeRegion( Page* p ) const;
+
+	/**
+		\brief Key of a page in the page index, the largest request the page is sure to serve. 
+			   That is the size of the region FindFreeBlock would pick, or for LAYOUT_BITMAP 
+			   the bound on the longest run of free granules.
+			   It is not the largest free region of the page: only the head of the largest 
+			   populated size class is looked at, and the other regions of that class may be 
+			   larger by less than one second level step. A request that falls in between skips 
+			   the page, see AcquireFreeBlock.
+	*/
+	std::size_t PageKey( Page* p ) const;
+
+	/**
+		\brief Bring the leaf of a page in the page index up to date, and its ancestors as long as their maximum changes
+	*/
+	void UpdatePageIndex( Page* p );
+
+	/**
+		\brief First page in list order, from a given position on, whose key reaches a given one
+		\param key		Smallest key accepted
+		\param from	Position in the page list the search starts at
+		\return The page, nullptr when no page from that position on has such a key
+	*/
+	Page* FindPage( std::size_t key, std::size_t from ) const;
+
+	/**
+		\brief Number the pages in list order and recompute every node of the page index
+	*/
+	void RebuildPageIndex();
+
+	/**
+		\brief Double the number of leaves of the page index
+	*/
+	void GrowPageIndex();
 
 	/**
 		\brief Allocates new set of memory of size pageSize for allocation needs
@@ -134,14 +858,351 @@ private:
 	*/
 	void FreeAllPages();
 
-	unsigned pageSize;			   /**< size of a memory chunk that constitute a page*/
-	unsigned fragmentThreshold;	   /**< size of fragmentation tolerance*/
-	unsigned pageCount;			   /**< number of allocated pages*/
+	/**
+		\brief Request a pageSize long chunk aligned to pageAlignment from the page source
+		\return The chunk. Throws std::bad_alloc on failure like operator new would
+	*/
+	char* AllocateChunk();
+
+	/**
+		\brief Give a chunk obtained from AllocateChunk back to the page source
+	*/
+	void FreeChunk( char* chunk );
+
+	/**
+		\brief Constant time lookup of the page a memory address handed out by Allocate resides in
+	*/
+	Page* PageFromAddress( void* object ) const;
+
+	/**
+		\brief Turn the whole chunk of a page into a single free region
+		\param p The page to initialize
+	*/
+	void InitializePage( Page* p );
+
+	/**
+		\brief Round a requested size up to what a region must hold
+	*/
+	static std::size_t RoundRequest( std::size_t size );
+
+	/**
+		\brief Find a free region of at least size bytes in any page, requesting a new page when none has one
+		\param size		Size of the requested memory, at most pageCapacity
+		\param alignment	Power of two the memory must be aligned to once carved, 0 for pointer alignment
+		\param page		Receives the page the region resides in
+		\return The meta data of the region, already removed from the free lists
+	*/
+	MetaData* AcquireFreeBlock( std::size_t size, unsigned alignment, Page*& page );
+
+	/**
+		\brief Find a free region in a page that can hold size bytes without scanning the page
+		\param p		The page to search
+		\param size	Size of the requested memory
+		\return The meta data of the region, or nullptr if no size class of the page guarantees a fit
+	*/
+	MetaData* FindFreeBlock( Page* p, std::size_t size );
+
+	/**
+		\brief Mark a free region as used, splitting off the head room when it exceeds the fragment threshold
+		\param p		The page the region resides in
+		\param block	The free region, already removed from the free lists
+		\param size	Size of the requested memory
+		\return A pointer to the usable memory of the region
+	*/
+	void* CarveBlock( Page* p, MetaData* block, std::size_t size );
+
+	/**
+		\brief Split a free region into count used regions of size bytes placed back to back
+		\param p		The page the region resides in
+		\param block	The free region, already removed from the free lists and large enough
+		\param size	Size of every requested memory
+		\param count	Number of regions to carve
+		\param objects	Receives count pointers
+	*/
+	void CarveRun( Page* p, MetaData* block, std::size_t size, unsigned count, void** objects );
+
+	/**
+		\brief Check whether a memory address is a slab slot
+		\param p		The page the address resides in
+		\param object	The memory address
+		\return The slab, or nullptr for a regular region
+	*/
+	Slab* SlabFromAddress( Page* p, void* object ) const;
+
+	/**
+		\brief Pop a slot of the size class that fits size
+	*/
+	void* AllocateSlot( std::size_t size );
+
+	/**
+		\brief Push a slot back on its slab, releasing the slab once it is empty and not the last of its class
+	*/
+	void FreeSlot( Slab* slab, void* object );
+
+	/**
+		\brief Hand an empty slab back as a regular region
+	*/
+	void ReleaseSlab( Slab* slab );
+
+	/**
+		\brief Mark a used region as free and coalesce it with its free neighbours
+		\param p		The page the region resides in
+		\param block	The used region
+	*/
+	void ReleaseBlock( Page* p, MetaData* block );
+
+	/**
+		\brief Split the memory of a used region beyond size bytes off into a free region, 
+			   provided it exceeds the fragment threshold
+		\param p		The page the region resides in
+		\param block	The used region
+		\param size	Number of bytes the region keeps
+	*/
+	void ReleaseTail( Page* p, MetaData* block, std::size_t size );
+
+	/**
+		\brief Where the usable memory of a region starts once aligned by CarveAlignedBlock
+	*/
+	static std::uintptr_t AlignedPayload( MetaData* block, unsigned alignment );
+
+	/**
+		\brief Like CarveBlock, but the usable memory starts at a multiple of alignment. 
+			   The padding in front of it is returned to the free lists.
+		\param p			The page the region resides in
+		\param block		The free region, already removed from the free lists
+		\param size		Size of the requested memory
+		\param alignment	Power of two the usable memory must start at a multiple of
+		\return A pointer to the usable memory of the region
+	*/
+	void* CarveAlignedBlock( Page* p, MetaData* block, std::size_t size, unsigned alignment );
+
+	/**
+		\brief The region right after a given one, nullptr for the last region of the page
+	*/
+	MetaData* NextBlock( Page* p, MetaData* block ) const;
+
+	/**
+		\brief The region right before a given one, read from its trailing size word. 
+			   Only valid while block->prevAvailable is set.
+	*/
+	static MetaData* PrevBlock( MetaData* block );
+
+	/**
+		\brief Mark a region as used, letting the region after it know
+	*/
+	void MarkUsed( Page* p, MetaData* block );
+
+	/**
+		\brief Number of granules a region of size bytes takes, at least one
+	*/
+	static std::size_t RoundToGranules( std::size_t size );
+
+	/**
+		\brief Find count free granules in a row in a page
+		\param p		The page to search
+		\param count	Number of granules
+		\param step	The first granule must be a multiple of step
+		\return Index of the first granule, granuleCount when the page has no such run
+	*/
+	std::size_t FindGranuleRun( Page* p, std::size_t count, std::size_t step ) const;
+
+	/**
+		\brief Bitmap layout counterpart of AcquireFreeBlock, requesting a new page when no page has room
+		\param count	Number of granules
+		\param step	The first granule must be a multiple of step
+		\param page	Receives the page the run resides in
+		\return Index of the first granule of the run, not marked as used yet
+	*/
+	std::size_t AcquireGranules( std::size_t count, std::size_t step, Page*& page );
+
+	/**
+		\brief Mark count granules as one used region
+		\return A pointer to the memory of the region
+	*/
+	void* CarveGranules( Page* p, std::size_t first, std::size_t count );
+
+	/**
+		\brief Bitmap layout counterpart of Allocate and AllocateAligned
+		\param size		Size of the requested memory
+		\param alignment	Power of two the memory must start at a multiple of, 0 for granule alignment
+	*/
+	void* AllocateFromBitmap( std::size_t size, unsigned alignment );
+
+	/**
+		\brief Linear layout counterpart of Allocate and AllocateAligned, bumping the memory off the 
+			   arena page and moving on to the next page when it runs out
+		\param size		Size of the requested memory
+		\param alignment	Power of two the memory must start at a multiple of, 0 for pointer alignment
+	*/
+	void* AllocateLinear( std::size_t size, unsigned alignment );
+
+	/**
+		\brief Serve a request too large for a page with a mapping of its own
+		\param size		Size of the requested memory
+		\param alignment	Power of two the memory must start at a multiple of, 0 for pointer alignment
+	*/
+	void* AllocateLarge( std::size_t size, unsigned alignment );
+
+	/**
+		\brief Check whether a memory address was handed out by AllocateLarge
+		\return The large object, or nullptr for memory in a page
+	*/
+	LargeObject* LargeFromAddress( void* object ) const;
+
+	/**
+		\brief Unmap a large object
+	*/
+	void ReleaseLarge( LargeObject* large );
+
+	/**
+		\brief Bitmap layout counterpart of Reallocate for memory that is not a slab slot
+	*/
+	void* ReallocateGranules( Page* p, void* object, std::size_t size );
+
+	/**
+		\brief Index of the last granule of the region starting at first
+	*/
+	std::size_t LastGranule( Page* p, std::size_t first ) const;
+
+	/**
+		\brief Bitmap layout counterpart of ReleaseBlock. Clearing the bits is all it takes to coalesce.
+	*/
+	void ReleaseGranules( Page* p, void* object );
+
+	/**
+		\brief Release a region handed out by either layout that is not a slab slot
+	*/
+	void ReleaseRegion( Page* p, void* object );
+
+	/**
+		\brief Link a free region into the free list of its size class, writing its trailing size word
+	*/
+	void InsertFreeBlock( Page* p, MetaData* block );
+
+	/**
+		\brief Unlink a free region from the free list of its size class
+	*/
+	void RemoveFreeBlock( Page* p, MetaData* block );
+
+	/**
+		\brief Index of the most significant set bit, value must not be 0
+	*/
+	static unsigned HighestBit( std::size_t value );
+
+	/**
+		\brief Index of the least significant set bit, value must not be 0
+	*/
+	static unsigned LowestBit( std::size_t value );
+
+#if defined(MEMORY_MANAGER_LATENCY_STATS)
+	/**
+		\brief Time stamp counter, or the steady clock where there is none
+	*/
+	static unsigned long long ReadTimestamp();
+
+	/**
+		\brief Count the cycles since start in their power of two bucket of histogram
+	*/
+	static void RecordLatency( unsigned long long* histogram, unsigned long long start );
+#endif
+
+	/**
+		\brief Set count bits of a granule bitmap starting at bit first
+	*/
+	static void SetBits( unsigned* map, std::size_t first, std::size_t count );
+
+	/**
+		\brief Clear count bits of a granule bitmap starting at bit first
+	*/
+	static void ClearBits( unsigned* map, std::size_t first, std::size_t count );
+
+	/**
+		\brief Check a single bit of a granule bitmap
+	*/
+	static bool TestBit( const unsigned* map, std::size_t index );
+
+	/**
+		\brief First word at or after word that differs from pattern, words if none does
+	*/
+	static std::size_t SkipWords( const unsigned* map, std::size_t word, std::size_t words, unsigned pattern );
+
+	/**
+		\brief Index of the first set bit at or after from, words * 32 if there is none
+	*/
+	static std::size_t NextSetBit( const unsigned* map, std::size_t from, std::size_t words );
+
+	/**
+		\brief Index of the first clear bit at or after from, words * 32 if there is none
+	*/
+	static std::size_t NextClearBit( const unsigned* map, std::size_t from, std::size_t words );
+
+	/**
+		\brief Index of the last set bit at or before from, there must be one
+	*/
+	static std::size_t PrevSetBit( const unsigned* map, std::size_t from );
+
+	/**
+		\brief Append a record to a snapshot being gathered
+	*/
+	static void AppendRecord( std::vector<char>& buffer, const void* record, std::size_t size );
+
+	std::size_t pageSize;		   /**< size of a memory chunk that constitute a page*/
+	std::size_t pageAlignment;	   /**< power of two, at least pageSize, every chunk is aligned to*/
+	std::size_t fragmentThreshold; /**< size of fragmentation tolerance*/
+	bool	 bAdaptive;			   /**< a switch to indicate if the fragment threshold follows the request sizes*/
+	unsigned requestSamples;	   /**< requests counted since the thresholds were last updated*/
+	unsigned requestHistogram[FL_COUNT][SL_COUNT]; /**< recent requests per free list size class, halved as they age*/
+	std::size_t bandThresholds[FL_COUNT]; /**< adaptive fragment threshold per power of two of the request*/
+	std::size_t pageCount;		   /**< number of allocated pages*/
+	std::size_t pageCapacity;	   /**< size of the single free region of an empty page*/
+	std::size_t emptyPageCount;	   /**< number of pages without any live allocation*/
+	std::size_t trimHighWater;	   /**< empty page count that triggers trimming inside Free*/
+	std::size_t trimLowWater;	   /**< empty page count that trimming inside Free leaves behind*/
+
+	METADATA_LAYOUT layout;		   /**< where the regions are tracked*/
+	std::size_t granuleCount;	   /**< LAYOUT_BITMAP only, number of granules in a chunk*/
+	std::size_t granuleWords;	   /**< LAYOUT_BITMAP only, number of words of a granule bitmap, one bit more than granuleCount at least*/
+
+	unsigned slabSize;			   /**< power of two size and alignment of a slab, 0 when pages are too small for slabs*/
+	unsigned slabBytes;			   /**< length of the region behind a slab, slabSize less the boundary tag of the region after it*/
+	unsigned slabLimit;			   /**< largest request served by slabs, 0 when slabs are off*/
+	Slab*	 slabClasses[SLAB_MAX_SLOT_SIZE / sizeof(void*)]; /**< per slot size, the slabs with a free slot*/
+
+	PageSourcePolicy pageSource;   /**< supplies the chunks of memory pages are made of*/
+	PageSource largeSource;		   /**< maps the memory of requests too large for a page*/
+
+	LargeObject* largeObjects;	   /**< live large objects, the latest first*/
+	unsigned long long largeSerial; /**< large objects allocated so far*/
 
 	Page*	 pageList;			   /**< a link list of memory pages*/
 	Page*	 lastPage;			   /**< a pointer that points to the last allocated memory*/
+	Page*	 arenaPage;			   /**< LAYOUT_LINEAR only, the page allocations are bumped off, pages after it are empty*/
+
+	std::size_t* pageIndex;		   /**< tournament tree over the pages in list order, node i holds the largest key of nodes 2i and 2i+1 and the leaves start at node indexLeaves*/
+	Page**	 indexPages;		   /**< page of every leaf of the page index, nullptr past the last page*/
+	std::size_t indexLeaves;	   /**< power of two, number of leaves of the page index*/
+	std::size_t roverSlot;		   /**< NextFit only, slot of the page the last region came from*/
 
 	bool	 bAllocate;			   /**< a switch to indicate if user wants the manager to request for new page of memory when there is not enough to satisfy request*/
+	std::atomic<RemoteFree*> remoteFrees; /**< lock-free stack of memory released by other threads*/
+
+	bool	 bTrim;				   /**< a switch to indicate if Free should return empty pages once trimHighWater is exceeded*/
+
+	MemoryStats stats;			   /**< counters and histograms, the computed figures are filled in by GetStats*/
+
+	TraceWriter* trace;			   /**< records the requests while a trace runs, nullptr otherwise*/
+
+	HandleEntry* handles;		   /**< handle table, nullptr until the first handle is allocated*/
+	std::size_t handleCapacity;	   /**< number of slots of the handle table*/
+	std::size_t freeHandles;	   /**< first unused slot plus one, 0 when every slot is in use*/
+	Page* compactPage;			   /**< page Compact resumes sliding at, nullptr to start from the first page*/
 };
 
+/**
+	\brief The manager with the default policies
+*/
+typedef BasicVariableMemoryManager<> VariableMemoryManager;
+
+#include "MemoryManager.inl"
+
 #endif
\ No newline at end of file
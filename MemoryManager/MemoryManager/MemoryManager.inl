@@ -0,0 +1,3149 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 Xavier RX Tan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in the
+Software without restriction, including without limitation the rights to use, copy,
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the
+following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/****************************************************
+Author : Xavier Tan
+Email  : xavier.rx.tan@gmail.com / tan.ruixiang@digipen.edu
+
+VariableMemoryManager.inl
+
+*****************************************************/
+
+// Included at the end of MemoryManager.h, so any combination of 
+// policies, including ones of the user, is instantiated where it is used
+
+#include "HeapSnapshot.h"
+#include "AllocationTrace.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// define MEMORY_MANAGER_LATENCY_STATS to time every Allocate and Free,
+// otherwise the timing compiles out and only the counters remain
+#if defined(MEMORY_MANAGER_LATENCY_STATS)
+#include <chrono>
+#if !defined(_MSC_VER) && ( defined(__x86_64__) || defined(__i386__) )
+#include <x86intrin.h>
+#endif
+#endif
+
+// the bitmap layout scans 8 words per compare when AVX2 code generation
+// is enabled (/arch:AVX2, -mavx2). Define MEMORY_MANAGER_NO_SIMD to keep
+// the scalar scan regardless.
+#if defined(__AVX2__) && !defined(MEMORY_MANAGER_NO_SIMD)
+#define MEMORY_MANAGER_AVX2
+#include <immintrin.h>
+#endif
+
+// Description:
+// Index of the most significant set bit. value must not be 0.
+// Takes a whole size, so first level classes reach past 4 GB.
+template <class FitPolicy, class PageSourcePolicy>
+unsigned BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::HighestBit( std::size_t value )
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanReverse64( &index, value );
+	return static_cast<unsigned>(index);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse( &index, value );
+	return static_cast<unsigned>(index);
+#else
+	return static_cast<unsigned>( sizeof(unsigned long long) * 8 - 1 - __builtin_clzll( value ) );
+#endif
+}
+
+// Description:
+// Index of the least significant set bit. value must not be 0.
+template <class FitPolicy, class PageSourcePolicy>
+unsigned BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::LowestBit( std::size_t value )
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanForward64( &index, value );
+	return static_cast<unsigned>(index);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward( &index, value );
+	return static_cast<unsigned>(index);
+#else
+	return static_cast<unsigned>(__builtin_ctzll( value ));
+#endif
+}
+
+#if defined(MEMORY_MANAGER_LATENCY_STATS)
+// Description:
+// Cheapest clock there is, the time stamp counter on x86
+template <class FitPolicy, class PageSourcePolicy>
+unsigned long long BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ReadTimestamp()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return static_cast<unsigned long long>( std::chrono::steady_clock::now().time_since_epoch().count() );
+#endif
+}
+
+// Description:
+// Count the time since start in its power of two bucket
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::RecordLatency( unsigned long long* histogram, unsigned long long start )
+{
+	unsigned long long cycles = ReadTimestamp() - start;
+
+	++histogram[ cycles > 0xFFFFFFFFull ? 31 : HighestBit( static_cast<unsigned>(cycles) | 1u ) ];
+}
+#endif
+
+// Description:
+// Set count bits of a bitmap starting at bit first, a word at a time
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::SetBits( unsigned* map, std::size_t first, std::size_t count )
+{
+	while ( count )
+	{
+		unsigned bit = static_cast<unsigned>( first % 32 );
+		unsigned n = count < 32 - bit ? static_cast<unsigned>(count) : 32 - bit;
+
+		map[first / 32] |= ( n == 32 ? ~0u : ( ( 1u << n ) - 1 ) ) << bit;
+
+		first += n;
+		count -= n;
+	}
+}
+
+// Description:
+// Clear count bits of a bitmap starting at bit first, a word at a time
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ClearBits( unsigned* map, std::size_t first, std::size_t count )
+{
+	while ( count )
+	{
+		unsigned bit = static_cast<unsigned>( first % 32 );
+		unsigned n = count < 32 - bit ? static_cast<unsigned>(count) : 32 - bit;
+
+		map[first / 32] &= ~( ( n == 32 ? ~0u : ( ( 1u << n ) - 1 ) ) << bit );
+
+		first += n;
+		count -= n;
+	}
+}
+
+// Description:
+// Check a single bit of a bitmap
+template <class FitPolicy, class PageSourcePolicy>
+bool BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::TestBit( const unsigned* map, std::size_t index )
+{
+	return 0 != ( map[index / 32] & ( 1u << ( index % 32 ) ) );
+}
+
+// Description:
+// First word at or after word that differs from pattern, words if none does.
+// Fully used or fully free stretches of a bitmap are crossed 8 words at a
+// time with AVX2, a word at a time otherwise.
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::SkipWords( const unsigned* map, std::size_t word, std::size_t words, unsigned pattern )
+{
+#if defined(MEMORY_MANAGER_AVX2)
+	const __m256i same = _mm256_set1_epi32( static_cast<int>(pattern) );
+
+	for ( ; word + 8 <= words; word += 8 )
+	{
+		__m256i block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(map + word) );
+		unsigned equal = static_cast<unsigned>( _mm256_movemask_epi8( _mm256_cmpeq_epi32(block, same) ) );
+
+		if ( equal != ~0u )
+			return word + LowestBit(~equal) / 4;
+	}
+#endif
+
+	while ( word < words && map[word] == pattern )
+		++word;
+
+	return word;
+}
+
+// Description:
+// Index of the first set bit at or after from, words * 32 if there is none
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::NextSetBit( const unsigned* map, std::size_t from, std::size_t words )
+{
+	std::size_t word = from / 32;
+	unsigned bits = map[word] & ( ~0u << ( from % 32 ) );
+
+	if ( 0 == bits )
+	{
+		word = SkipWords(map, word + 1, words, 0u);
+
+		if ( word == words )
+			return words * 32;
+
+		bits = map[word];
+	}
+
+	return word * 32 + LowestBit(bits);
+}
+
+// Description:
+// Index of the first clear bit at or after from, words * 32 if there is none
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::NextClearBit( const unsigned* map, std::size_t from, std::size_t words )
+{
+	std::size_t word = from / 32;
+	unsigned bits = ~map[word] & ( ~0u << ( from % 32 ) );
+
+	if ( 0 == bits )
+	{
+		word = SkipWords(map, word + 1, words, ~0u);
+
+		if ( word == words )
+			return words * 32;
+
+		bits = ~map[word];
+	}
+
+	return word * 32 + LowestBit(bits);
+}
+
+// Description:
+// Index of the last set bit at or before from. There must be one.
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::PrevSetBit( const unsigned* map, std::size_t from )
+{
+	std::size_t word = from / 32;
+	unsigned bits = map[word] & ( from % 32 == 31 ? ~0u : ( ( 1u << ( from % 32 + 1 ) ) - 1 ) );
+
+	while ( 0 == bits )
+		bits = map[--word];
+
+	return word * 32 + HighestBit(bits);
+}
+
+// Description:
+// Constructor
+template <class FitPolicy, class PageSourcePolicy>
+BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::BasicVariableMemoryManager(const std::size_t& _pageSizeInBytes, const std::size_t& _fragmentThreshold,
+											 bool _allocateUponNoFreeSpace, unsigned _pageSourceFlags, METADATA_LAYOUT _layout)
+		: pageSize(_pageSizeInBytes), fragmentThreshold(_fragmentThreshold), layout(_layout), pageSource(_pageSourceFlags), 
+		  largeSource ( _pageSourceFlags | PAGE_SOURCE_MAPPED ), largeObjects ( nullptr ), largeSerial ( 0 ),
+		  pageIndex ( nullptr ), indexPages ( nullptr ), indexLeaves ( 0 ), roverSlot ( 0 ),
+		  bAllocate ( _allocateUponNoFreeSpace ), remoteFrees ( nullptr ), bTrim ( false ),
+		  trace ( nullptr ), handles ( nullptr ), handleCapacity ( 0 ), freeHandles ( 0 ), compactPage ( nullptr )
+{
+	// chunks are aligned to the smallest power of two that covers a page
+	// so that Free can find the owning page from an address alone
+	pageAlignment = sizeof(void*);
+
+	while ( pageAlignment < pageSize )
+		pageAlignment <<= 1;
+
+	pageCapacity = pageSize - sizeof(PageHeader) - sizeof(MetaData);
+	granuleCount = granuleWords = 0;
+
+	// the bitmap layout gives up the granules the page header lies in
+	if ( LAYOUT_BITMAP == layout )
+	{
+		granuleCount = pageSize / GRANULE_SIZE;
+		granuleWords = granuleCount / GRANULE_BITS + 1;
+		pageCapacity = ( granuleCount - ( sizeof(PageHeader) + GRANULE_SIZE - 1 ) / GRANULE_SIZE ) * GRANULE_SIZE;
+	}
+
+	// the arena writes nothing but the page header
+	if ( LAYOUT_LINEAR == layout )
+		pageCapacity = pageSize - sizeof(PageHeader);
+
+	// a slab is an aligned region, so a page must be able to hold
+	// one in the worst case. Pages too small for that go without.
+	// Small slabs waste less in front of the first one of a page.
+	slabSize = SLAB_MAX_SIZE;
+
+	while ( slabSize > 4 * SLAB_MAX_SLOT_SIZE && SLAB_PAGE_FRACTION * slabSize > pageSize )
+		slabSize >>= 1;
+
+	while ( slabSize >= 4 * SLAB_MAX_SLOT_SIZE && 2 * slabSize + sizeof(MetaData) + MIN_BLOCK_SIZE > pageCapacity )
+		slabSize >>= 1;
+
+	if ( slabSize < 4 * SLAB_MAX_SLOT_SIZE || LAYOUT_LINEAR == layout )
+		slabSize = 0;
+
+	// the boundary tag of the region after a slab takes the last word
+	// before the next slabSize boundary, so consecutive slabs tile the
+	// page. Bitmap regions have no tag and fill the whole stretch.
+	slabBytes = slabSize && LAYOUT_INLINE == layout ? slabSize - static_cast<unsigned>( sizeof(MetaData) ) : slabSize;
+
+	slabLimit = 0;
+
+	SetAdaptiveThreshold(false);
+
+	for ( unsigned i = 0; i < SLAB_MAX_SLOT_SIZE / sizeof(void*); ++i )
+		slabClasses[i] = nullptr;
+
+	// immediately allocate memory upon construction
+	pageList = new Page;
+	pageList->Next = nullptr;
+
+	try 
+	{
+		pageList->chunk = AllocateChunk();
+	}
+	catch(std::bad_alloc)
+	{
+		// build simple log file
+		std::ofstream logFile("Log_File.txt");
+		logFile << "Bad Allocation detected upon VariableMemoryManager's construction. Application Terminated." << std::endl;
+		logFile.close();
+		// close the program
+		abort();
+	}
+
+	// the first page takes the first leaf of the page index
+	pageList->slot = 0;
+	GrowPageIndex();
+	indexPages[0] = pageList;
+
+	InitializePage(pageList);
+
+	// lastPage will always points to most recent requested memory
+	lastPage = arenaPage = pageList;
+
+	pageCount = 1;
+	emptyPageCount = 1;
+	trimHighWater = trimLowWater = 0;
+
+	stats = MemoryStats();
+	stats.pageRequests = 1;
+}
+
+// Description:
+// Destructor
+template <class FitPolicy, class PageSourcePolicy>
+BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::~BasicVariableMemoryManager()
+{
+	StopTrace();
+	FreeAllPages();
+
+	while ( largeObjects )
+		ReleaseLarge(largeObjects);
+
+	delete [] handles;
+	delete [] pageIndex;
+	delete [] indexPages;
+}
+
+// Description:
+// One of 2 main interactions for memory operations
+// that is exposed to the end user.
+// Counts the allocation on top of AllocateObject
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Allocate( const std::size_t& size )
+{
+#if defined(MEMORY_MANAGER_LATENCY_STATS)
+	unsigned long long start = ReadTimestamp();
+#endif
+
+	void* object = AllocateObject(size);
+
+	if ( object )
+		RecordAllocation(object, size, 0);
+
+#if defined(MEMORY_MANAGER_LATENCY_STATS)
+	RecordLatency(stats.allocateCycles, start);
+#endif
+
+	return object;
+}
+
+// Description:
+// Look up the segregated free lists of each page for a
+// free region that is guaranteed to satisfy the required memory need
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AllocateObject( std::size_t size )
+{
+	if ( size <= slabLimit )
+		return AllocateSlot(size);
+
+	if ( LAYOUT_BITMAP == layout )
+		return AllocateFromBitmap(size, 0);
+
+	if ( LAYOUT_LINEAR == layout )
+		return AllocateLinear(size, 0);
+
+	// too large for a page, the request gets a mapping of its own.
+	// Checked before rounding, which sizes near the top would wrap.
+	if ( size > pageCapacity ) 
+		return AllocateLarge(size, 0);
+
+	std::size_t request = RoundRequest(size);
+
+	if ( request > pageCapacity ) 
+		return AllocateLarge(size, 0);
+
+	Page* p = nullptr;
+	MetaData* block = AcquireFreeBlock(request, 0, p);
+
+	return CarveBlock(p, block, request);
+}
+
+// Description:
+// Counts the allocations on top of AllocateBatchObjects
+template <class FitPolicy, class PageSourcePolicy>
+unsigned BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AllocateBatch( const std::size_t& size, unsigned count, void** objects )
+{
+	unsigned done = AllocateBatchObjects(size, count, objects);
+
+	for ( unsigned i = 0; i < done; ++i )
+		RecordAllocation(objects[i], size, 0);
+
+	return done;
+}
+
+// Description:
+// Carve as many regions as possible out of a single free region, one
+// right after the other, so the search and the free list update are paid
+// once per run rather than once per region. A run never spans pages, so
+// large batches take one run per page.
+template <class FitPolicy, class PageSourcePolicy>
+unsigned BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AllocateBatchObjects( std::size_t size, unsigned count, void** objects )
+{
+	if ( size <= slabLimit )
+	{
+		for ( unsigned i = 0; i < count; ++i )
+		{
+			if ( nullptr == ( objects[i] = AllocateSlot(size) ) )
+				return i;
+		}
+
+		return count;
+	}
+
+	// regions too large for a page cannot share a mapping
+	if ( size > pageCapacity || RoundRequest(size) > pageCapacity )
+	{
+		for ( unsigned i = 0; i < count; ++i )
+		{
+			if ( nullptr == ( objects[i] = AllocateLarge(size, 0) ) )
+				return i;
+		}
+
+		return count;
+	}
+
+	if ( LAYOUT_BITMAP == layout )
+	{
+		std::size_t granules = RoundToGranules(size);
+		std::size_t perRun = pageCapacity / GRANULE_SIZE / granules;
+		unsigned done = 0;
+
+		while ( done < count )
+		{
+			unsigned run = count - done < perRun ? count - done : static_cast<unsigned>(perRun);
+
+			Page* p = nullptr;
+			std::size_t first = AcquireGranules(run * granules, 1, p);
+
+			for ( unsigned i = 0; i < run; ++i )
+				objects[done + i] = CarveGranules(p, first + i * granules, granules);
+
+			done += run;
+		}
+
+		return done;
+	}
+
+	if ( LAYOUT_LINEAR == layout )
+	{
+		for ( unsigned i = 0; i < count; ++i )
+		{
+			if ( nullptr == ( objects[i] = AllocateLinear(size, 0) ) )
+				return i;
+		}
+
+		return count;
+	}
+
+	std::size_t request = RoundRequest(size);
+	std::size_t stride = request + sizeof(MetaData);
+	std::size_t perPage = ( pageCapacity + sizeof(MetaData) ) / stride;
+	unsigned done = 0;
+
+	while ( done < count )
+	{
+		unsigned run = count - done;
+
+		if ( run > perPage )
+			run = static_cast<unsigned>(perPage);
+
+		Page* p = nullptr;
+		MetaData* block = AcquireFreeBlock(run * stride - sizeof(MetaData), 0, p);
+
+		CarveRun(p, block, request, run, objects + done);
+
+		done += run;
+	}
+
+	return done;
+}
+
+// Description:
+// Counts the allocation on top of AllocateAlignedObject
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AllocateAligned( const std::size_t& size, const unsigned& alignment )
+{
+	void* object = AllocateAlignedObject(size, alignment);
+
+	if ( object )
+		RecordAllocation(object, size, alignment);
+
+	return object;
+}
+
+// Description:
+// Same as Allocate, but the region handed out starts on a multiple of
+// alignment. The search asks for enough room to align in the worst case,
+// and whatever lies before the aligned address goes back to the free lists.
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AllocateAlignedObject( std::size_t size, unsigned alignment )
+{
+	if ( 0 == alignment || ( alignment & ( alignment - 1 ) ) )
+		return nullptr;
+
+	// every region is at least pointer aligned already
+	if ( alignment <= sizeof(void*) )
+		return AllocateObject(size);
+
+	if ( LAYOUT_BITMAP == layout )
+		return AllocateFromBitmap(size, alignment);
+
+	if ( LAYOUT_LINEAR == layout )
+		return AllocateLinear(size, alignment);
+
+	if ( size > pageCapacity ) 
+		return AllocateLarge(size, alignment);
+
+	std::size_t request = RoundRequest(size);
+	std::size_t worstCase = request + alignment + sizeof(MetaData) + MIN_BLOCK_SIZE;
+
+	if ( worstCase > pageCapacity ) 
+		return AllocateLarge(size, alignment);
+
+	Page* p = nullptr;
+	MetaData* block = AcquireFreeBlock(request, alignment, p);
+
+	return CarveAlignedBlock(p, block, request, alignment);
+}
+
+// Description:
+// Counts the bytes gained or lost on top of ReallocateObject
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Reallocate( void* object, const std::size_t& size )
+{
+	if ( nullptr == object )
+		return Allocate(size);
+
+	if ( 0 == size )
+	{
+		Free(object);
+		return nullptr;
+	}
+
+	// the arena keeps the old memory until it is rolled back
+	std::size_t before = LAYOUT_LINEAR == layout ? 0 : GetAllocationSize(object);
+	void* resized = ReallocateObject(object, size);
+
+	if ( resized )
+	{
+		++stats.reallocations;
+		stats.bytesInUse = stats.bytesInUse - before + GetAllocationSize(resized);
+
+		if ( stats.bytesInUse > stats.peakBytesInUse )
+			stats.peakBytesInUse = stats.bytesInUse;
+
+		if ( trace )
+		{
+			trace->Write(TRACE_REALLOCATE, object, size, 0);
+			trace->Write(TRACE_REALLOCATED, resized, size, 0);
+		}
+	}
+
+	return resized;
+}
+
+// Description:
+// Resize in place whenever the neighbourhood allows it. Shrinking hands
+// the tail back under the usual fragment threshold rule, growing takes
+// over the next region when it is free and large enough. Only when
+// neither works is the memory moved to a new region.
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ReallocateObject( void* object, std::size_t size )
+{
+	// the arena keeps no sizes, so everything up to the end of what the
+	// page handed out may belong to the object. It is measured before
+	// the new memory is bumped off the same page.
+	if ( LAYOUT_LINEAR == layout )
+	{
+		std::size_t extent = GetAllocationSize(object);
+		void* moved = AllocateLinear(size, 0);
+
+		if ( moved )
+			memcpy(moved, object, size < extent ? size : extent);
+
+		return moved;
+	}
+
+	// a large object keeps its mapping as long as the memory fits in it
+	if ( LargeObject* large = LargeFromAddress(object) )
+	{
+		if ( size <= large->usable )
+			return object;
+
+		void* moved = AllocateObject(size);
+
+		if ( nullptr == moved )
+			return nullptr;
+
+		memcpy(moved, object, large->usable);
+		ReleaseLarge(large);
+
+		return moved;
+	}
+
+	Page* p = PageFromAddress(object);
+
+	if ( Slab* slab = SlabFromAddress(p, object) )
+	{
+		if ( size <= slab->slotSize )
+			return object;
+
+		void* moved = AllocateObject(size);
+
+		if ( nullptr == moved )
+			return nullptr;
+
+		memcpy(moved, object, slab->slotSize);
+		FreeSlot(slab, object);
+
+		return moved;
+	}
+
+	if ( LAYOUT_BITMAP == layout )
+		return ReallocateGranules(p, object, size);
+
+	std::size_t request = RoundRequest(size);
+
+	MetaData* block = reinterpret_cast<MetaData*>( reinterpret_cast<char*>(object) - sizeof(MetaData) );
+
+	if ( request <= block->Size )
+	{
+		ReleaseTail(p, block, request);
+		return object;
+	}
+
+	MetaData* next = NextBlock(p, block);
+
+	if ( next && next->available && block->Size + sizeof(MetaData) + next->Size >= request )
+	{
+		RemoveFreeBlock(p, next);
+
+		block->Size += next->Size + sizeof(MetaData);
+		p->memLeft -= next->Size;
+
+		MarkUsed(p, block);
+		ReleaseTail(p, block, request);
+		return object;
+	}
+
+	void* moved = AllocateObject(size);
+
+	if ( nullptr == moved )
+		return nullptr;
+
+	memcpy(moved, object, block->Size);
+	FreeObject(object);
+
+	return moved;
+}
+
+// Description:
+// The page header and the large object header are written once, when the
+// chunk is mapped, so other threads may read them
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::GetMappedSize( void* object ) const
+{
+	LargeObject* large = LargeFromAddress(object);
+
+	return large ? large->usable : 0;
+}
+
+// Description:
+// Accessor
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::GetAllocationSize( void* object ) const
+{
+	if ( LargeObject* large = LargeFromAddress(object) )
+		return large->usable;
+
+	Page* p = PageFromAddress(object);
+
+	if ( Slab* slab = SlabFromAddress(p, object) )
+		return slab->slotSize;
+
+	if ( LAYOUT_BITMAP == layout )
+	{
+		std::size_t first = ( static_cast<char*>(object) - p->chunk ) / GRANULE_SIZE;
+		return ( LastGranule(p, first) - first + 1 ) * GRANULE_SIZE;
+	}
+
+	if ( LAYOUT_LINEAR == layout )
+		return static_cast<std::size_t>( p->chunk + pageSize - p->memLeft - static_cast<char*>(object) );
+
+	return reinterpret_cast<MetaData*>( reinterpret_cast<char*>(object) - sizeof(MetaData) )->Size;
+}
+
+// Description:
+// Counts the release on top of FreeObject
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Free( void* object )
+{
+#if defined(MEMORY_MANAGER_LATENCY_STATS)
+	unsigned long long start = ReadTimestamp();
+#endif
+
+	RecordFree(object);
+	FreeObject(object);
+
+#if defined(MEMORY_MANAGER_LATENCY_STATS)
+	RecordLatency(stats.freeCycles, start);
+#endif
+}
+
+// Description:
+// Take the address and free the data for future writes.
+// Also coalesce with near by free memory.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::FreeObject( void* object )
+{
+	// arena memory only goes back through Rollback and Reset
+	if ( LAYOUT_LINEAR == layout )
+		return;
+
+	if ( LargeObject* large = LargeFromAddress(object) )
+	{
+		ReleaseLarge(large);
+		return;
+	}
+
+	// the parent page meta header is found from the address
+	// itself to update available memory size
+	Page* p = PageFromAddress(object);
+
+	if ( Slab* slab = SlabFromAddress(p, object) )
+	{
+		FreeSlot(slab, object);
+		return;
+	}
+
+	ReleaseRegion(p, object);
+
+	// the page may just have turned empty, which may be one too many
+	if ( bTrim && emptyPageCount > trimHighWater )
+		ReturnUnusedMemory(trimLowWater);
+}
+
+// Description:
+// Sort the addresses so that regions of the same page come together in
+// address order. A run of regions that sit right next to each other is
+// merged into a single region first, so the free lists and the
+// neighbouring regions are only visited once per run rather than once
+// per address.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::FreeBatch( void** objects, unsigned count )
+{
+	if ( LAYOUT_LINEAR == layout )
+		return;
+
+	// slab slots and bitmap regions have no neighbours to 
+	// coalesce with, they are released on the spot
+	unsigned regions = 0;
+
+	for ( unsigned i = 0; i < count; ++i )
+	{
+		RecordFree(objects[i]);
+
+		if ( LargeObject* large = LargeFromAddress(objects[i]) )
+		{
+			ReleaseLarge(large);
+			continue;
+		}
+
+		Page* p = PageFromAddress(objects[i]);
+
+		if ( Slab* slab = SlabFromAddress(p, objects[i]) )
+			FreeSlot(slab, objects[i]);
+		else if ( LAYOUT_BITMAP == layout )
+			ReleaseGranules(p, objects[i]);
+		else
+			objects[regions++] = objects[i];
+	}
+
+	count = regions;
+
+	std::sort(objects, objects + count);
+
+	unsigned i = 0;
+
+	while ( i < count )
+	{
+		MetaData* run = reinterpret_cast<MetaData*>( reinterpret_cast<char*>(objects[i]) - sizeof(MetaData) );
+		Page* p = PageFromAddress(objects[i]);
+
+		for ( ++i; i < count; ++i )
+		{
+			MetaData* next = reinterpret_cast<MetaData*>( reinterpret_cast<char*>(objects[i]) - sizeof(MetaData) );
+
+			if ( next != NextBlock(p, run) )
+				break;
+
+			run->Size += next->Size + sizeof(MetaData);
+		}
+
+		ReleaseBlock(p, run);
+	}
+
+	if ( bTrim && emptyPageCount > trimHighWater )
+		ReturnUnusedMemory(trimLowWater);
+}
+
+// Description:
+// Hand a used region back to the free lists of its page
+// and coalesce with near by free memory.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ReleaseBlock( Page* p, MetaData* metaData )
+{
+	p->memLeft += metaData->Size;
+
+	// attempt to coalesce within immediate memory vacinity.
+	// The neighbours leave their free lists since the merged
+	// region will most likely fall in a different size class
+	MetaData* next = NextBlock(p, metaData);
+
+	if ( next && next->available )
+	{
+		RemoveFreeBlock(p, next);
+
+		metaData->Size += next->Size + sizeof(MetaData);
+
+		p->memLeft += sizeof(MetaData);
+	}
+
+	// the previous region is only looked up when its tag says it is free,
+	// since only free regions carry the trailing size word
+	if ( metaData->prevAvailable )
+	{
+		MetaData* prev = PrevBlock(metaData);
+
+		RemoveFreeBlock(p, prev);
+
+		prev->Size += metaData->Size + sizeof(MetaData);
+
+		p->memLeft += sizeof(MetaData);
+
+		metaData = prev;
+	}
+
+	InsertFreeBlock(p, metaData);
+
+	if ( p->memLeft == pageCapacity )
+		++emptyPageCount;
+}
+
+// Description:
+// The region holds the handle in its first word, so that a region
+// found by walking a page leads back to its slot in the handle table.
+// Regions of the inline layout skip the slabs and are flagged movable.
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Handle BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AllocateHandle( const std::size_t& size )
+{
+	// the handle word in front would wrap the size around
+	if ( size > ~static_cast<std::size_t>(0) - sizeof(std::size_t) )
+		return INVALID_HANDLE;
+
+	std::size_t request = size + sizeof(std::size_t);
+	void* payload = nullptr;
+
+	if ( LAYOUT_BITMAP == layout )
+		payload = AllocateFromBitmap(request, 0);
+	else if ( LAYOUT_LINEAR == layout )
+		payload = AllocateLinear(request, 0);
+	else if ( request > pageCapacity || RoundRequest(request) > pageCapacity )
+		payload = AllocateLarge(request, 0);
+	else
+	{
+		Page* p = nullptr;
+		MetaData* block = AcquireFreeBlock(RoundRequest(request), 0, p);
+
+		payload = CarveBlock(p, block, RoundRequest(request));
+		block->movable = true;
+	}
+
+	if ( nullptr == payload )
+		return INVALID_HANDLE;
+
+	RecordAllocation(payload, request, 0);
+
+	Handle handle = NewHandle(reinterpret_cast<char*>(payload) + sizeof(std::size_t));
+
+	*reinterpret_cast<std::size_t*>(payload) = handle;
+
+	return handle;
+}
+
+// Description:
+// Accessor
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Resolve( Handle handle ) const
+{
+	return INVALID_HANDLE == handle ? nullptr : EntryOf(handle).object;
+}
+
+// Description:
+// Compact leaves regions of pinned handles where they are
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Pin( Handle handle )
+{
+	if ( INVALID_HANDLE == handle )
+		return nullptr;
+
+	HandleEntry& entry = EntryOf(handle);
+
+	++entry.pins;
+
+	return entry.object;
+}
+
+// Description:
+// Counterpart of Pin
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Unpin( Handle handle )
+{
+	if ( INVALID_HANDLE == handle )
+		return;
+
+	--EntryOf(handle).pins;
+}
+
+// Description:
+// Release the region, then put the slot on the list of unused slots
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::FreeHandle( Handle handle )
+{
+	if ( INVALID_HANDLE == handle )
+		return;
+
+	HandleEntry& entry = EntryOf(handle);
+	void* payload = reinterpret_cast<char*>(entry.object) - sizeof(std::size_t);
+
+	entry.object = nullptr;
+	entry.pins = 0;
+	entry.nextFree = freeHandles;
+	freeHandles = handle;
+
+	RecordFree(payload);
+	FreeObject(payload);
+}
+
+// Description:
+// Handles are slot indices plus one so that 0 stays invalid.
+// The table doubles when it runs full, handles stay the same.
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Handle BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::NewHandle( void* object )
+{
+	if ( 0 == freeHandles )
+	{
+		std::size_t capacity = handleCapacity ? 2 * handleCapacity : static_cast<std::size_t>(HANDLE_TABLE_INITIAL);
+		HandleEntry* table = new HandleEntry[capacity];
+
+		for ( std::size_t i = 0; i < handleCapacity; ++i )
+			table[i] = handles[i];
+
+		for ( std::size_t i = handleCapacity; i < capacity; ++i )
+		{
+			table[i].object = nullptr;
+			table[i].pins = 0;
+			table[i].nextFree = i + 1 < capacity ? i + 2 : 0;
+		}
+
+		delete [] handles;
+
+		handles = table;
+		freeHandles = handleCapacity + 1;
+		handleCapacity = capacity;
+	}
+
+	Handle handle = freeHandles;
+	HandleEntry& entry = handles[handle - 1];
+
+	freeHandles = entry.nextFree;
+
+	entry.object = object;
+	entry.pins = 0;
+	entry.nextFree = 0;
+
+	return handle;
+}
+
+// Description:
+// Accessor, the callers turn INVALID_HANDLE away before it gets here
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::HandleEntry& BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::EntryOf( Handle handle ) const
+{
+	return handles[handle - 1];
+}
+
+// Description:
+// Only used regions from AllocateHandle are flagged movable,
+// the pins are read through the handle in their first word
+template <class FitPolicy, class PageSourcePolicy>
+bool BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::IsMovable( MetaData* block ) const
+{
+	if ( block->available || !block->movable )
+		return false;
+
+	std::size_t handle = *reinterpret_cast<std::size_t*>( reinterpret_cast<char*>(block) + sizeof(MetaData) );
+
+	return 0 == EntryOf(static_cast<Handle>(handle)).pins;
+}
+
+// Description:
+// A move shows up in a trace as a reallocation to the same size,
+// which keeps a replay able to follow the memory
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Relocated( void* from, MetaData* block )
+{
+	char* payload = reinterpret_cast<char*>(block) + sizeof(MetaData);
+
+	EntryOf(static_cast<Handle>(*reinterpret_cast<std::size_t*>(payload))).object = payload + sizeof(std::size_t);
+
+	if ( trace )
+	{
+		trace->Write(TRACE_REALLOCATE, from, block->Size, 0);
+		trace->Write(TRACE_REALLOCATED, payload, block->Size, 0);
+	}
+}
+
+// Description:
+// The two regions swap places. The moved region takes over the header
+// of the free region, and the free region gets a new header right
+// after the moved memory, from where it merges with the next region.
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::MetaData* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::SlideDown( Page* p, MetaData* hole, MetaData* block )
+{
+	std::size_t holeSize = hole->Size;
+	std::size_t blockSize = block->Size;
+	bool prevAvailable = hole->prevAvailable;
+
+	void* from = reinterpret_cast<char*>(block) + sizeof(MetaData);
+
+	std::memmove(reinterpret_cast<char*>(hole) + sizeof(MetaData), from, blockSize);
+
+	MetaData* moved = hole;
+
+	moved->Size = blockSize;
+	moved->available = false;
+	moved->prevAvailable = prevAvailable;
+	moved->movable = true;
+
+	hole = reinterpret_cast<MetaData*>( reinterpret_cast<char*>(moved) + sizeof(MetaData) + blockSize );
+
+	hole->Size = holeSize;
+	hole->available = false;
+	hole->prevAvailable = false;
+	hole->movable = false;
+
+	MetaData* next = NextBlock(p, hole);
+
+	if ( next && next->available )
+	{
+		RemoveFreeBlock(p, next);
+
+		hole->Size += next->Size + sizeof(MetaData);
+
+		p->memLeft += sizeof(MetaData);
+	}
+
+	Relocated(from, moved);
+
+	return hole;
+}
+
+// Description:
+// Walk the page and push every run of movable regions that follows a
+// free region down over it, carrying the free memory along to the end
+// of the run. The deadline is checked before every move, and every
+// few regions of the walk so a page without holes is no exception.
+template <class FitPolicy, class PageSourcePolicy>
+bool BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::SlidePage( Page* p, std::chrono::steady_clock::time_point deadline, std::size_t& moved )
+{
+	MetaData* block = reinterpret_cast<MetaData*>(p->chunk + sizeof(PageHeader));
+	unsigned walked = 0;
+
+	while ( block )
+	{
+		if ( 0 == ++walked % COMPACT_CLOCK_INTERVAL && std::chrono::steady_clock::now() >= deadline )
+			return false;
+
+		MetaData* next = NextBlock(p, block);
+
+		if ( !block->available || nullptr == next || !IsMovable(next) )
+		{
+			block = next;
+			continue;
+		}
+
+		RemoveFreeBlock(p, block);
+
+		while ( next && IsMovable(next) )
+		{
+			if ( std::chrono::steady_clock::now() >= deadline )
+			{
+				InsertFreeBlock(p, block);
+				return false;
+			}
+
+			moved += next->Size;
+
+			block = SlideDown(p, block, next);
+			next = NextBlock(p, block);
+		}
+
+		InsertFreeBlock(p, block);
+
+		block = next;
+	}
+
+	return true;
+}
+
+// Description:
+// Pages at most half full are worth emptying, provided nothing in them
+// is pinned or was handed out by anything but AllocateHandle. The walk
+// over the pages and their regions gives up once the deadline passes.
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Page* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::SparsestMovablePage( std::chrono::steady_clock::time_point deadline ) const
+{
+	Page* sparsest = nullptr;
+	unsigned walked = 0;
+
+	for ( Page* p = pageList; p; p = p->Next )
+	{
+		if ( 0 == ++walked % COMPACT_CLOCK_INTERVAL && std::chrono::steady_clock::now() >= deadline )
+			return nullptr;
+
+		if ( p->memLeft == pageCapacity || 2 * static_cast<std::size_t>(p->memLeft) < pageCapacity )
+			continue;
+
+		if ( sparsest && p->memLeft <= sparsest->memLeft )
+			continue;
+
+		bool movable = true;
+
+		for ( MetaData* block = reinterpret_cast<MetaData*>(p->chunk + sizeof(PageHeader)); block && movable; block = NextBlock(p, block) )
+		{
+			if ( 0 == ++walked % COMPACT_CLOCK_INTERVAL && std::chrono::steady_clock::now() >= deadline )
+				return nullptr;
+
+			movable = block->available || IsMovable(block);
+		}
+
+		if ( movable )
+			sparsest = p;
+	}
+
+	return sparsest;
+}
+
+// Description:
+// Regions only move to pages fuller than the one being emptied, so the
+// pages never trade regions back and forth over successive calls
+template <class FitPolicy, class PageSourcePolicy>
+bool BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::EvacuatePage( Page* p, std::chrono::steady_clock::time_point deadline, std::size_t& moved )
+{
+	MetaData* block = reinterpret_cast<MetaData*>(p->chunk + sizeof(PageHeader));
+
+	while ( block )
+	{
+		if ( block->available )
+		{
+			block = NextBlock(p, block);
+			continue;
+		}
+
+		if ( std::chrono::steady_clock::now() >= deadline )
+			return false;
+
+		std::size_t size = block->Size;
+
+		Page* target = FindPage(size, 0);
+
+		while ( target && ( target == p || target->memLeft >= p->memLeft ) )
+			target = FindPage(size, target->slot + 1);
+
+		if ( nullptr == target )
+			return false;
+
+		MetaData* copy = FindFreeBlock(target, size);
+
+		void* from = reinterpret_cast<char*>(block) + sizeof(MetaData);
+		void* to = CarveBlock(target, copy, size);
+
+		std::memcpy(to, from, size);
+
+		// the fragment threshold may hand out a little more than before
+		copy->movable = true;
+		stats.bytesInUse += copy->Size - size;
+
+		Relocated(from, copy);
+
+		moved += size;
+
+		// the released region merges with its free neighbours, so the
+		// walk resumes from the merged region
+		MetaData* resume = block->prevAvailable ? PrevBlock(block) : block;
+
+		ReleaseBlock(p, block);
+
+		block = NextBlock(p, resume);
+	}
+
+	return true;
+}
+
+// Description:
+// Slide first, page by page from where the last call stopped. Once
+// every page is done, empty the sparsest pages into the others.
+// Releasing the page the slide stopped at moves the slide on to the next.
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Compact( unsigned budgetMicroseconds )
+{
+	if ( LAYOUT_INLINE != layout )
+		return 0;
+
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budgetMicroseconds);
+	std::size_t moved = 0;
+
+	for ( Page* p = compactPage ? compactPage : pageList; p; p = p->Next )
+	{
+		compactPage = p;
+
+		if ( !SlidePage(p, deadline, moved) )
+			return moved;
+	}
+
+	compactPage = nullptr;
+
+	while ( Page* sparse = SparsestMovablePage(deadline) )
+	{
+		if ( !EvacuatePage(sparse, deadline, moved) )
+			break;
+	}
+
+	if ( bTrim && emptyPageCount > trimHighWater )
+		ReturnUnusedMemory(trimLowWater);
+
+	return moved;
+}
+
+// Description:
+// The arena page and how far it got is all it takes, every page
+// after the arena page is empty
+template <class FitPolicy, class PageSourcePolicy>
+ArenaMarker BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Mark() const
+{
+	ArenaMarker marker;
+
+	marker.page = arenaPage;
+	marker.memLeft = arenaPage->memLeft;
+	marker.bytesInUse = stats.bytesInUse;
+	marker.largeObjects = largeSerial;
+
+	return marker;
+}
+
+// Description:
+// Pages from the one after the marked page up to the arena page are
+// emptied wholesale and the marked page gets its memory left back. 
+// No region is visited, so the cost only depends on the pages touched.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Rollback( const ArenaMarker& marker )
+{
+	if ( LAYOUT_LINEAR != layout || nullptr == marker.page )
+		return;
+
+	Page* page = static_cast<Page*>(marker.page);
+
+	for ( Page* p = page; p != arenaPage; )
+	{
+		p = p->Next;
+
+		if ( p->memLeft != pageCapacity )
+		{
+			p->memLeft = pageCapacity;
+			++emptyPageCount;
+		}
+	}
+
+	if ( page->memLeft != pageCapacity && marker.memLeft == pageCapacity )
+		++emptyPageCount;
+
+	page->memLeft = marker.memLeft;
+	arenaPage = page;
+
+	// the latest large objects come first
+	while ( largeObjects && largeObjects->serial >= marker.largeObjects )
+		ReleaseLarge(largeObjects);
+
+	stats.bytesInUse = marker.bytesInUse;
+
+	if ( bTrim && emptyPageCount > trimHighWater )
+		ReturnUnusedMemory(trimLowWater);
+}
+
+// Description:
+// Called from threads that do not own the manager. The region is pushed
+// on a lock-free stack that only the owner ever empties, and it empties it
+// as a whole, so no node is ever popped and reused while another thread
+// holds it. That keeps the push free of the ABA problem.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::FreeRemote( void* object )
+{
+	RemoteFree* node = reinterpret_cast<RemoteFree*>(object);
+	RemoteFree* head = remoteFrees.load(std::memory_order_relaxed);
+
+	do
+	{
+		node->Next = head;
+	}
+	while ( !remoteFrees.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed) );
+}
+
+// Description:
+// Take the whole remote free stack at once and release it locally
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ReclaimRemoteFrees()
+{
+	RemoteFree* node = remoteFrees.exchange(nullptr, std::memory_order_acquire);
+
+	while ( node )
+	{
+		RemoteFree* next = node->Next;
+		Free(node);
+		node = next;
+	}
+}
+
+// Description:
+// Relaxed peek so the owner can skip the exchange when nothing is queued
+template <class FitPolicy, class PageSourcePolicy>
+bool BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::HasRemoteFrees() const
+{
+	return nullptr != remoteFrees.load(std::memory_order_relaxed);
+}
+
+// Description:
+// Every manager with the same page size aligns its chunks the same way,
+// so any of them can read the page header of another manager's address.
+template <class FitPolicy, class PageSourcePolicy>
+BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::OwnerOf( void* object ) const
+{
+	std::uintptr_t base = reinterpret_cast<std::uintptr_t>(object) & ~static_cast<std::uintptr_t>( pageAlignment - 1 );
+
+	return reinterpret_cast<PageHeader*>(base)->manager;
+}
+
+// Description :
+// Walk the pages and release the ones whose whole chunk is a single free
+// region. Since Free locates pages through the chunk header rather than an
+// index, unlinking a page leaves every other page untouched.
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ReturnUnusedMemory( std::size_t pagesToKeep )
+{
+	// empty slabs kept around for their size class would pin their page
+	for ( unsigned i = 0; i < SLAB_MAX_SLOT_SIZE / sizeof(void*); ++i )
+	{
+		Slab* slab = slabClasses[i];
+
+		while ( slab )
+		{
+			Slab* next = slab->Next;
+
+			if ( 0 == slab->liveSlots )
+				ReleaseSlab(slab);
+
+			slab = next;
+		}
+	}
+
+	std::size_t released = 0;
+	std::size_t kept = 0;
+
+	Page* prev = nullptr;
+	Page* p = pageList;
+
+	while ( p && emptyPageCount > pagesToKeep )
+	{
+		Page* next = p->Next;
+
+		// the arena page is kept to allocate from even when empty
+		if ( p->memLeft != pageCapacity || kept < pagesToKeep || ( LAYOUT_LINEAR == layout && arenaPage == p ) )
+		{
+			if ( p->memLeft == pageCapacity )
+				++kept;
+
+			prev = p;
+			p = next;
+			continue;
+		}
+
+		if ( prev )
+			prev->Next = next;
+		else
+			pageList = next;
+
+		if ( lastPage == p )
+			lastPage = prev;
+
+		if ( compactPage == p )
+			compactPage = next;
+
+		FreeChunk(p->chunk);
+		delete [] p->slabMap;
+		delete [] p->usedMap;
+		delete p;
+
+		--pageCount;
+		--emptyPageCount;
+		++released;
+		++stats.pageReleases;
+
+		p = next;
+	}
+
+	// the pages after a released one moved up the list
+	if ( released )
+		RebuildPageIndex();
+
+	return released;
+}
+
+// Description :
+// Every page is turned back into a single free region as if it had just
+// been requested, so the cost depends on the number of pages only. 
+// Slabs, handles and remote frees all point into the pages, they go too.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Reset( std::size_t pagesToKeep )
+{
+	for ( unsigned i = 0; i < SLAB_MAX_SLOT_SIZE / sizeof(void*); ++i )
+		slabClasses[i] = nullptr;
+
+	delete [] handles;
+	handles = nullptr;
+	handleCapacity = freeHandles = 0;
+	compactPage = nullptr;
+
+	remoteFrees.store(nullptr, std::memory_order_relaxed);
+
+	while ( largeObjects )
+		ReleaseLarge(largeObjects);
+
+	bool decommitted = true;
+	std::size_t index = 0;
+
+	for ( Page* p = pageList; p; p = p->Next, ++index )
+	{
+		delete [] p->slabMap;
+		delete [] p->usedMap;
+
+		InitializePage(p);
+
+		// the page header and the header of the free region stay committed
+		if ( index >= pagesToKeep )
+		{
+			std::size_t header = sizeof(PageHeader) + sizeof(MetaData) + sizeof(FreeLinks);
+
+			decommitted = pageSource.Decommit(p->chunk + header, pageSize - header) && decommitted;
+		}
+	}
+
+	emptyPageCount = pageCount;
+	arenaPage = pageList;
+	stats.bytesInUse = 0;
+
+	if ( trace )
+		trace->Write(TRACE_RESET, nullptr, pagesToKeep, 0);
+
+	// heap chunks cannot be decommitted, they are returned instead
+	if ( !decommitted )
+		ReturnUnusedMemory(pagesToKeep);
+}
+
+// Description :
+// The counters are kept up to date as memory comes and goes, the rest
+// is gathered from the pages on demand
+template <class FitPolicy, class PageSourcePolicy>
+MemoryStats BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::GetStats() const
+{
+	MemoryStats snapshot = stats;
+
+	snapshot.bytesFree = 0;
+	snapshot.largestFreeBlock = 0;
+	snapshot.pageCount = pageCount;
+	snapshot.emptyPageCount = emptyPageCount;
+
+	snapshot.largeObjectCount = 0;
+	snapshot.largeObjectBytes = 0;
+
+	for ( LargeObject* large = largeObjects; large; large = large->Next )
+	{
+		++snapshot.largeObjectCount;
+		snapshot.largeObjectBytes += large->length;
+	}
+
+	for ( Page* p = pageList; p; p = p->Next )
+	{
+		snapshot.bytesFree += p->memLeft;
+
+		std::size_t largest = LargestFreeRegion(p);
+
+		if ( largest > snapshot.largestFreeBlock )
+			snapshot.largestFreeBlock = largest;
+	}
+
+	snapshot.externalFragmentation = snapshot.bytesFree ? 1.0 - static_cast<double>(snapshot.largestFreeBlock) / snapshot.bytesFree : 0.0;
+
+	return snapshot;
+}
+
+// Description :
+// Clear the event counters and histograms, leaving the bytes in use 
+// as they are and the peak at the current usage
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ResetStats()
+{
+	std::size_t bytesInUse = stats.bytesInUse;
+
+	stats = MemoryStats();
+	stats.bytesInUse = stats.peakBytesInUse = bytesInUse;
+}
+
+// Description :
+// Fill in the memory left of as many pages as there is room for
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::GetPageMemLeft( std::size_t* memLeft, std::size_t maxPages ) const
+{
+	std::size_t i = 0;
+
+	for ( Page* p = pageList; p && i < maxPages; p = p->Next )
+		memLeft[i++] = p->memLeft;
+
+	return pageCount;
+}
+
+// Description :
+// Usable size of the new memory, and the size class of the request
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::RecordAllocation( void* object, std::size_t size, unsigned alignment )
+{
+	++stats.allocations;
+	++stats.sizeClasses[ size ? HighestBit(size) : 0 ];
+
+	stats.bytesInUse += GetAllocationSize(object);
+
+	if ( stats.bytesInUse > stats.peakBytesInUse )
+		stats.peakBytesInUse = stats.bytesInUse;
+
+	if ( trace )
+		trace->Write(TRACE_ALLOCATE, object, size, alignment);
+
+	if ( bAdaptive )
+		SampleRequest(size);
+}
+
+// Description :
+// Looked up before the memory is gone
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::RecordFree( void* object )
+{
+	// nothing is released in an arena until it is rolled back
+	if ( LAYOUT_LINEAR == layout )
+		return;
+
+	++stats.frees;
+	stats.bytesInUse -= GetAllocationSize(object);
+
+	if ( trace )
+		trace->Write(TRACE_FREE, object, 0, 0);
+}
+
+// Description :
+// Bitmap pages measure every free run, other pages walk the list
+// of their largest populated size class
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::LargestFreeRegion( Page* p ) const
+{
+	std::size_t largest = 0;
+
+	if ( LAYOUT_BITMAP == layout )
+	{
+		std::size_t first = NextClearBit(p->usedMap, 0, granuleWords);
+
+		while ( first < granuleCount )
+		{
+			std::size_t used = NextSetBit(p->usedMap, first, granuleWords);
+
+			if ( used - first > largest )
+				largest = used - first;
+
+			first = NextClearBit(p->usedMap, used, granuleWords);
+		}
+
+		return largest * GRANULE_SIZE;
+	}
+
+	if ( LAYOUT_LINEAR == layout )
+		return p->memLeft;
+
+	if ( 0 == p->flBitmap )
+		return 0;
+
+	unsigned topFl = HighestBit(p->flBitmap);
+	MetaData* block = p->freeLists[topFl][HighestBit(p->slBitmap[topFl])];
+
+	for ( ; block; block = reinterpret_cast<FreeLinks*>( reinterpret_cast<char*>(block) + sizeof(MetaData) )->NextFree )
+	{
+		if ( block->Size > largest )
+			largest = block->Size;
+	}
+
+	return largest;
+}
+
+// Description :
+// The thresholds restart from the one given upon
+// construction along with a fresh histogram
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::SetAdaptiveThreshold( bool enable )
+{
+	bAdaptive = enable;
+	requestSamples = 0;
+
+	for ( unsigned fl = 0; fl < FL_COUNT; ++fl )
+	{
+		bandThresholds[fl] = fragmentThreshold;
+
+		for ( unsigned sl = 0; sl < SL_COUNT; ++sl )
+			requestHistogram[fl][sl] = 0;
+	}
+}
+
+// Description :
+// Rounded the way the request itself would be
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::GetFragmentThreshold( std::size_t size ) const
+{
+	return FragmentThreshold(RoundRequest(size));
+}
+
+// Description :
+// Requests are counted in the size classes of the free lists,
+// which are fine enough to tell vertices from small meshes
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::SampleRequest( std::size_t size )
+{
+	std::size_t request = RoundRequest(size);
+	unsigned fl = HighestBit(request);
+	unsigned sl = static_cast<unsigned>( request >> ( fl - SL_LOG2 ) ) & ( SL_COUNT - 1 );
+
+	++requestHistogram[fl][sl];
+
+	if ( ++requestSamples == ADAPTIVE_UPDATE_INTERVAL )
+	{
+		requestSamples = 0;
+		UpdateThresholds();
+	}
+}
+
+// Description :
+// Headroom becomes a free region of its own only if the requests
+// that follow are likely to use it: when a fair share of them fit
+// in it, or when another request like the one it is cut from does.
+// Anything smaller would linger as a sliver no request can use.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::UpdateThresholds()
+{
+	unsigned long long total = 0;
+
+	for ( unsigned fl = 0; fl < FL_COUNT; ++fl )
+	{
+		for ( unsigned sl = 0; sl < SL_COUNT; ++sl )
+			total += requestHistogram[fl][sl];
+	}
+
+	if ( 0 == total )
+		return;
+
+	// the smallest size that a fair share of the requests fit in,
+	// the exclusive upper bound of the class where they add up
+	unsigned long long reusable = 0;
+	unsigned long long covered = 0;
+
+	for ( unsigned fl = 0; fl < FL_COUNT && 0 == reusable; ++fl )
+	{
+		for ( unsigned sl = 0; sl < SL_COUNT; ++sl )
+		{
+			covered += requestHistogram[fl][sl];
+
+			if ( covered * ADAPTIVE_REUSE_SHARE >= total )
+			{
+				reusable = ( 1ull << fl ) + ( static_cast<unsigned long long>( sl + 1 ) << ( fl - SL_LOG2 ) );
+				break;
+			}
+		}
+	}
+
+	for ( unsigned fl = 0; fl < FL_COUNT; ++fl )
+	{
+		// any request of the power of two fits in twice its lower bound
+		unsigned long long limit = std::min(reusable, 2ull << fl);
+
+		bandThresholds[fl] = static_cast<std::size_t>(limit - 1);
+	}
+
+	// older requests fade out
+	if ( total > ADAPTIVE_HISTORY )
+	{
+		for ( unsigned fl = 0; fl < FL_COUNT; ++fl )
+		{
+			for ( unsigned sl = 0; sl < SL_COUNT; ++sl )
+				requestHistogram[fl][sl] >>= 1;
+		}
+	}
+}
+
+// Description :
+// Per power of two of the request while adaptive
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::FragmentThreshold( std::size_t request ) const
+{
+	return bAdaptive ? bandThresholds[ HighestBit(request) ] : fragmentThreshold;
+}
+
+// Description :
+// Slot sizes are pointer sized steps, so the limit is capped to the
+// number of size classes there are
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::SetSlabLimit( unsigned maxSlotSize )
+{
+	if ( maxSlotSize > SLAB_MAX_SLOT_SIZE )
+		maxSlotSize = SLAB_MAX_SLOT_SIZE;
+
+	slabLimit = slabSize ? maxSlotSize : 0;
+}
+
+// Description :
+// Turn on trimming inside Free
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::SetTrimPolicy( std::size_t highWaterPages, std::size_t lowWaterPages )
+{
+	trimHighWater = highWaterPages;
+	trimLowWater = lowWaterPages < highWaterPages ? lowWaterPages : highWaterPages;
+	bTrim = true;
+}
+
+// Description :
+// Turn off trimming inside Free
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::DisableTrimPolicy()
+{
+	bTrim = false;
+}
+
+// Description :
+// FindFreeBlock takes the head of the largest populated size class, and
+// succeeds exactly when that region is large enough. This is a lower
+// bound of the largest free region, not the region itself: the heads
+// of a class are not sorted, and finding the largest would mean walking
+// the class on every free list update.
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::PageKey( Page* p ) const
+{
+	if ( LAYOUT_BITMAP == layout )
+		return p->longestRun;
+
+	if ( 0 == p->flBitmap )
+		return 0;
+
+	unsigned topFl = HighestBit(p->flBitmap);
+
+	return p->freeLists[topFl][HighestBit(p->slBitmap[topFl])]->Size;
+}
+
+// Description :
+// Most free list updates leave the key alone, or only change
+// the leaf, so the walk up the tree usually stops right away
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::UpdatePageIndex( Page* p )
+{
+	std::size_t node = indexLeaves + p->slot;
+	std::size_t key = PageKey(p);
+
+	if ( pageIndex[node] == key )
+		return;
+
+	pageIndex[node] = key;
+
+	for ( node >>= 1; node; node >>= 1 )
+	{
+		std::size_t larger = std::max(pageIndex[2 * node], pageIndex[2 * node + 1]);
+
+		if ( pageIndex[node] == larger )
+			break;
+
+		pageIndex[node] = larger;
+	}
+}
+
+// Description :
+// Climb from the leaf until a subtree to the right holds a large enough
+// key, then descend to its leftmost leaf that does. Both walks are at
+// most the height of the tree.
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Page* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::FindPage( std::size_t key, std::size_t from ) const
+{
+	if ( from >= indexLeaves )
+		return nullptr;
+
+	std::size_t node = indexLeaves + from;
+
+	while ( pageIndex[node] < key )
+	{
+		// the next subtree to the right is the sibling of
+		// the first ancestor that is a left child
+		while ( node & 1 )
+			node >>= 1;
+
+		// the root was reached from its rightmost leaf
+		if ( 0 == node )
+			return nullptr;
+
+		++node;
+	}
+
+	while ( node < indexLeaves )
+		node = pageIndex[2 * node] >= key ? 2 * node : 2 * node + 1;
+
+	return indexPages[node - indexLeaves];
+}
+
+// Description :
+// Leaves past the last page hold 0, which no request asks for
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::RebuildPageIndex()
+{
+	std::size_t slot = 0;
+
+	// the pages are renumbered, NextFit starts over
+	roverSlot = 0;
+
+	for ( Page* p = pageList; p; p = p->Next, ++slot )
+	{
+		p->slot = slot;
+		indexPages[slot] = p;
+		pageIndex[indexLeaves + slot] = PageKey(p);
+	}
+
+	for ( ; slot < indexLeaves; ++slot )
+	{
+		indexPages[slot] = nullptr;
+		pageIndex[indexLeaves + slot] = 0;
+	}
+
+	for ( std::size_t node = indexLeaves - 1; node; --node )
+		pageIndex[node] = std::max(pageIndex[2 * node], pageIndex[2 * node + 1]);
+}
+
+// Description :
+// The leaves keep their order, so the pages keep their slots
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::GrowPageIndex()
+{
+	std::size_t leaves = indexLeaves ? 2 * indexLeaves : 1;
+
+	std::size_t* index = new std::size_t[2 * leaves]();
+	Page** pages = new Page*[leaves]();
+
+	for ( std::size_t i = 0; i < indexLeaves; ++i )
+	{
+		index[leaves + i] = pageIndex[indexLeaves + i];
+		pages[i] = indexPages[i];
+	}
+
+	for ( std::size_t node = leaves - 1; node; --node )
+		index[node] = std::max(index[2 * node], index[2 * node + 1]);
+
+	delete [] pageIndex;
+	delete [] indexPages;
+
+	pageIndex = index;
+	indexPages = pages;
+	indexLeaves = leaves;
+}
+
+// Description :
+// Allocate a pageSize long chunk of memory for present and future allocation.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::RequestPage()
+{
+	// if for some reason user choose not to allocate new memory 
+	// ( i.e user had already allocated a sizable proportion 
+	// from the main memory avaliable), then we will terminate 
+	// the application and consider it a bad allocation.
+	if ( !bAllocate )
+	{
+		// Clear everything
+		FreeAllPages();
+
+		// build simple log file
+		std::ofstream logFile("Log_File.txt");
+		logFile << "Bad Allocation detected. Application Terminated." << std::endl;
+		logFile.close();
+		// close the program
+		abort();
+	}
+
+	// create new Page node
+	Page* p = new Page;
+
+	// attempt to request for a large chunk of memory of pageSize
+	try
+	{
+		p->Next = nullptr;
+		p->chunk = AllocateChunk();
+	}
+	catch(std::bad_alloc) // bad allocation detected
+	{
+		FreeAllPages();
+
+		// build simple log file
+		std::ofstream logFile("Log_File.txt");
+		logFile << "Bad Allocation detected. Application Terminated." << std::endl;
+		logFile.close();
+		// close the program
+		abort();
+	}
+
+	// the new page takes the leaf after the last page
+	if ( pageCount == indexLeaves )
+		GrowPageIndex();
+
+	p->slot = pageCount;
+	indexPages[p->slot] = p;
+
+	InitializePage(p);
+	
+	// every page may have been returned to the system by now
+	if ( lastPage )
+		lastPage->Next = p;
+	else
+		pageList = p;
+
+	lastPage = p;
+	++pageCount;
+	++emptyPageCount;
+	++stats.pageRequests;
+}
+
+// Description :
+// Request an aligned chunk from the page source. Reported with
+// std::bad_alloc so callers handle it the same way as operator new.
+template <class FitPolicy, class PageSourcePolicy>
+char* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AllocateChunk()
+{
+	void* chunk = pageSource.Acquire( pageSize, pageAlignment );
+
+	if ( nullptr == chunk )
+		throw std::bad_alloc();
+
+	return static_cast<char*>(chunk);
+}
+
+// Description :
+// Hand a chunk back to the page source
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::FreeChunk( char* chunk )
+{
+	pageSource.Release( chunk, pageSize );
+}
+
+// Description :
+// Accessor
+template <class FitPolicy, class PageSourcePolicy>
+PAGE_SOURCE_MODE BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::GetPageSourceMode() const
+{
+	return pageSource.Mode();
+}
+
+// Description :
+// Accessor
+template <class FitPolicy, class PageSourcePolicy>
+METADATA_LAYOUT BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::GetLayout() const
+{
+	return layout;
+}
+
+// Description :
+// Every chunk starts on a pageAlignment boundary and is at most that long,
+// so masking off the low bits of any address inside it lands on its header.
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Page* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::PageFromAddress( void* object ) const
+{
+	std::uintptr_t base = reinterpret_cast<std::uintptr_t>(object) & ~static_cast<std::uintptr_t>( pageAlignment - 1 );
+
+	return reinterpret_cast<PageHeader*>(base)->owner;
+}
+
+// Description :
+// Reset the free lists of a page and hand its whole chunk to them as one region.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::InitializePage( Page* p )
+{
+	reinterpret_cast<PageHeader*>(p->chunk)->owner = p;
+	reinterpret_cast<PageHeader*>(p->chunk)->manager = this;
+
+	p->flBitmap = 0;
+	p->slabMap = nullptr;
+	p->usedMap = p->endMap = nullptr;
+
+	for ( unsigned fl = 0; fl < FL_COUNT; ++fl )
+	{
+		p->slBitmap[fl] = 0;
+
+		for ( unsigned sl = 0; sl < SL_COUNT; ++sl )
+			p->freeLists[fl][sl] = nullptr;
+	}
+
+	if ( LAYOUT_BITMAP == layout )
+	{
+		p->usedMap = new unsigned[2 * granuleWords]();
+		p->endMap = p->usedMap + granuleWords;
+
+		// the page header and the bits past the end of the chunk, of
+		// which there is at least one, are never handed out so runs
+		// of free granules always end on a used one
+		SetBits(p->usedMap, 0, ( sizeof(PageHeader) + GRANULE_SIZE - 1 ) / GRANULE_SIZE);
+		SetBits(p->usedMap, granuleCount, granuleWords * GRANULE_BITS - granuleCount);
+
+		p->memLeft = pageCapacity;
+		p->longestRun = pageCapacity / GRANULE_SIZE;
+
+		UpdatePageIndex(p);
+		return;
+	}
+
+	// the used part of an arena page is the front of the chunk
+	// up to memLeft bytes before its end
+	if ( LAYOUT_LINEAR == layout )
+	{
+		p->memLeft = pageCapacity;
+		return;
+	}
+
+	MetaData* metaData = reinterpret_cast<MetaData*>(p->chunk + sizeof(PageHeader));
+
+	metaData->Size = p->memLeft = pageSize - sizeof(PageHeader) - sizeof(MetaData);
+	metaData->prevAvailable = false;
+
+	InsertFreeBlock(p, metaData);
+}
+
+// Description :
+// Every region must be able to hold its free list links once it is
+// released, and keeping the sizes pointer aligned keeps the meta data
+// headers that follow aligned as well. Sizes past the last aligned
+// one stay there rather than wrap around to a small request.
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::RoundRequest( std::size_t size )
+{
+	std::size_t largest = ~static_cast<std::size_t>( sizeof(void*) - 1 );
+
+	if ( size > largest )
+		return largest;
+
+	std::size_t request = ( size + sizeof(void*) - 1 ) & ~static_cast<std::size_t>( sizeof(void*) - 1 );
+
+	if ( request < MIN_BLOCK_SIZE )
+		request = MIN_BLOCK_SIZE;
+
+	return request;
+}
+
+// Description :
+// The page index hands out the first page whose size classes can hold 
+// the request in O(log P), so neither the number of live regions nor 
+// the number of pages that are too full is walked through.
+// NextFit starts at the page the last region came from and wraps around.
+// Aligned requests ask for room to align in the worst case, and
+// failing that check whether the largest region of the pages large 
+// enough happens to be placed well enough to hold the request once aligned.
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::MetaData* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AcquireFreeBlock( std::size_t size, unsigned alignment, Page*& page )
+{
+	bool aligned = alignment > sizeof(void*);
+	std::size_t search = aligned ? size + alignment + sizeof(MetaData) + MIN_BLOCK_SIZE : size;
+
+	Page* p = FindPage(search, FitPolicy::RESUME_AT_LAST_PAGE ? roverSlot : 0);
+
+	if ( FitPolicy::RESUME_AT_LAST_PAGE && !p && roverSlot )
+		p = FindPage(search, 0);
+
+	// a page whose key reaches the request always serves it
+	if ( p )
+	{
+		roverSlot = p->slot;
+
+		page = p;
+		return FindFreeBlock(p, search);
+	}
+
+	for ( Page* p = aligned ? FindPage(size, 0) : nullptr; p; p = FindPage(size, p->slot + 1) )
+	{
+		unsigned topFl = HighestBit(p->flBitmap);
+		MetaData* largest = p->freeLists[topFl][HighestBit(p->slBitmap[topFl])];
+
+		std::uintptr_t payload = reinterpret_cast<std::uintptr_t>(largest) + sizeof(MetaData);
+
+		if ( AlignedPayload(largest, alignment) + size <= payload + largest->Size )
+		{
+			RemoveFreeBlock(p, largest);
+
+			page = p;
+			return largest;
+		}
+	}
+
+	// We have exhusted our search, so we have no choice but to 
+	// request for a new set of empty page, which holds a single
+	// free region large enough for any request within pageCapacity.
+	// The keys are lower bounds, so a page may still hold a region 
+	// large enough behind the head of its largest class. It is not 
+	// looked for, the lookup stays O(log P) at the cost of the page.
+	RequestPage();
+
+	roverSlot = lastPage->slot;
+
+	page = lastPage;
+	return FindFreeBlock(lastPage, search);
+}
+
+// Description :
+// Two level size class lookup. The request is rounded up to the next
+// class boundary so that every region of the selected class is large enough.
+// WorstFit and NextFit take the largest populated class of the page to keep 
+// the worst-fit placement of the original linear search, BestFit and FirstFit
+// the smallest one from the rounded class on, found with two bit scans.
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::MetaData* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::FindFreeBlock( Page* p, std::size_t size )
+{
+	if ( 0 == p->flBitmap )
+		return nullptr;
+
+	unsigned fl = HighestBit(size);
+	std::size_t roundedSize = size + ( static_cast<std::size_t>(1) << ( fl - SL_LOG2 ) ) - 1;
+
+	// FirstFit gives the head of the request's own class a chance first,
+	// it is often large enough and keeps the larger classes intact
+	if ( FitPolicy::OWN_CLASS_FIRST )
+	{
+		unsigned ownSl = static_cast<unsigned>( size >> ( fl - SL_LOG2 ) ) & ( SL_COUNT - 1 );
+		MetaData* own = p->freeLists[fl][ownSl];
+
+		if ( own && own->Size >= size )
+		{
+			RemoveFreeBlock(p, own);
+			return own;
+		}
+	}
+
+	fl = HighestBit(roundedSize);
+	unsigned sl = static_cast<unsigned>( roundedSize >> ( fl - SL_LOG2 ) ) & ( SL_COUNT - 1 );
+
+	if ( FitPolicy::SMALLEST_CLASS )
+	{
+		unsigned slMask = p->slBitmap[fl] & ( ~0u << sl );
+		std::size_t flMask = fl + 1 < FL_COUNT ? p->flBitmap & ( ~static_cast<std::size_t>(0) << ( fl + 1 ) ) : 0;
+
+		if ( slMask || flMask )
+		{
+			unsigned bestFl = slMask ? fl : LowestBit(flMask);
+			unsigned bestSl = LowestBit( slMask ? slMask : p->slBitmap[bestFl] );
+
+			MetaData* block = p->freeLists[bestFl][bestSl];
+
+			RemoveFreeBlock(p, block);
+
+			return block;
+		}
+	}
+
+	unsigned topFl = HighestBit(p->flBitmap);
+	unsigned topSl = HighestBit(p->slBitmap[topFl]);
+
+	MetaData* block = p->freeLists[topFl][topSl];
+
+	// the largest populated class may still be the request's own class,
+	// in which case only its head is examined to keep the lookup constant.
+	// This is what lets a freshly requested page serve a large request.
+	if ( topFl < fl || ( topFl == fl && topSl < sl ) )
+	{
+		if ( block->Size < size )
+			return nullptr;
+	}
+
+	RemoveFreeBlock(p, block);
+
+	return block;
+}
+
+// Description :
+// Hand out a free region. If there is still head room in the region
+// that can be split to allow new allocation between this and the next
+// region, it goes back to the free lists. Determined by asset sizes.
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::CarveBlock( Page* p, MetaData* block, std::size_t size )
+{
+	// an empty page is about to receive its first allocation
+	if ( p->memLeft == pageCapacity )
+		--emptyPageCount;
+
+	// if there are no headroom we will just give the full chunk
+	// that block describes. The excess will be considered as 
+	// fragmentation but this fragmentation is considered as minimized 
+	// because the user had prescribed a certain threshold of tolerance 
+	// that they are willing to accept base on their assets' size
+	MarkUsed(p, block);
+	p->memLeft -= block->Size;
+
+	ReleaseTail(p, block, size);
+
+	return reinterpret_cast<void*>(reinterpret_cast<char*>(block) + sizeof(MetaData));
+}
+
+// Description :
+// Split count regions of size bytes off the front of a free region. The
+// remainder is handled like the head room of a single allocation.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::CarveRun( Page* p, MetaData* block, std::size_t size, unsigned count, void** objects )
+{
+	// an empty page is about to receive its first allocation
+	if ( p->memLeft == pageCapacity )
+		--emptyPageCount;
+
+	p->memLeft -= block->Size;
+
+	MarkUsed(p, block);
+
+	for ( unsigned i = 0; i < count; ++i )
+	{
+		objects[i] = reinterpret_cast<char*>(block) + sizeof(MetaData);
+
+		if ( i + 1 == count )
+			break;
+
+		MetaData* next = reinterpret_cast<MetaData*>( reinterpret_cast<char*>(block) + sizeof(MetaData) + size );
+
+		next->Size = block->Size - size - sizeof(MetaData);
+		next->available = false;
+		next->prevAvailable = false;
+		next->movable = false;
+
+		block->Size = size;
+
+		block = next;
+	}
+
+	ReleaseTail(p, block, size);
+}
+
+// Description :
+// Slabs are aligned to slabSize, and the page keeps one bit per slabSize
+// stretch of its chunk, so a single bit test tells slots from regions.
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::Slab* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::SlabFromAddress( Page* p, void* object ) const
+{
+	if ( nullptr == p->slabMap )
+		return nullptr;
+
+	std::uintptr_t address = reinterpret_cast<std::uintptr_t>(object);
+	std::uintptr_t index = ( address & ( pageAlignment - 1 ) ) / slabSize;
+
+	if ( 0 == ( p->slabMap[index / 8] & ( 1u << ( index % 8 ) ) ) )
+		return nullptr;
+
+	return reinterpret_cast<Slab*>( address & ~static_cast<std::uintptr_t>( slabSize - 1 ) );
+}
+
+// Description :
+// A slot comes off the free list of the first slab of its size class,
+// or from the part of that slab never handed out yet. Only when the size
+// class has no slab with room left is a new slab carved out of a page.
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AllocateSlot( std::size_t size )
+{
+	unsigned slotSize = static_cast<unsigned>( ( size + sizeof(void*) - 1 ) & ~( sizeof(void*) - 1 ) );
+
+	if ( 0 == slotSize )
+		slotSize = sizeof(void*);
+
+	Slab*& head = slabClasses[slotSize / sizeof(void*) - 1];
+	Slab* slab = head;
+
+	if ( nullptr == slab )
+	{
+		char* memory = static_cast<char*>( AllocateAlignedObject(slabBytes, slabSize) );
+
+		if ( nullptr == memory )
+			return nullptr;
+
+		Page* p = PageFromAddress(memory);
+
+		if ( nullptr == p->slabMap )
+		{
+			std::size_t bytes = ( pageAlignment / slabSize + 7 ) / 8;
+			p->slabMap = new unsigned char[bytes]();
+		}
+
+		std::uintptr_t index = ( reinterpret_cast<std::uintptr_t>(memory) & ( pageAlignment - 1 ) ) / slabSize;
+		p->slabMap[index / 8] |= static_cast<unsigned char>( 1u << ( index % 8 ) );
+
+		slab = reinterpret_cast<Slab*>(memory);
+		slab->Next = slab->Prev = nullptr;
+		slab->freeSlots = nullptr;
+		slab->unused = memory + sizeof(Slab);
+		slab->slotSize = slotSize;
+		slab->liveSlots = 0;
+
+		head = slab;
+	}
+
+	void* slot = slab->freeSlots;
+
+	if ( slot )
+	{
+		slab->freeSlots = *reinterpret_cast<void**>(slot);
+	}
+	else
+	{
+		slot = slab->unused;
+		slab->unused += slotSize;
+	}
+
+	++slab->liveSlots;
+
+	// a full slab leaves its size class until a slot comes back
+	if ( nullptr == slab->freeSlots && slab->unused + slotSize > reinterpret_cast<char*>(slab) + slabBytes )
+	{
+		head = slab->Next;
+
+		if ( head )
+			head->Prev = nullptr;
+
+		slab->Next = slab->Prev = nullptr;
+	}
+
+	return slot;
+}
+
+// Description :
+// Push the slot on the free list of its slab. A slab that was full joins
+// its size class again, one that runs empty is released unless it is the
+// only slab left in its size class, which saves carving a new slab on
+// the next small allocation.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::FreeSlot( Slab* slab, void* object )
+{
+	bool wasFull = nullptr == slab->freeSlots && slab->unused + slab->slotSize > reinterpret_cast<char*>(slab) + slabBytes;
+
+	*reinterpret_cast<void**>(object) = slab->freeSlots;
+	slab->freeSlots = object;
+	--slab->liveSlots;
+
+	Slab*& head = slabClasses[slab->slotSize / sizeof(void*) - 1];
+
+	if ( wasFull )
+	{
+		slab->Prev = nullptr;
+		slab->Next = head;
+
+		if ( head )
+			head->Prev = slab;
+
+		head = slab;
+	}
+
+	if ( 0 == slab->liveSlots && ( head != slab || slab->Next ) )
+		ReleaseSlab(slab);
+}
+
+// Description :
+// Unlink an empty slab from its size class and free it as a region
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ReleaseSlab( Slab* slab )
+{
+	Slab*& head = slabClasses[slab->slotSize / sizeof(void*) - 1];
+
+	if ( slab->Prev )
+		slab->Prev->Next = slab->Next;
+	else
+		head = slab->Next;
+
+	if ( slab->Next )
+		slab->Next->Prev = slab->Prev;
+
+	Page* p = PageFromAddress(slab);
+
+	std::uintptr_t index = ( reinterpret_cast<std::uintptr_t>(slab) & ( pageAlignment - 1 ) ) / slabSize;
+	p->slabMap[index / 8] &= static_cast<unsigned char>( ~( 1u << ( index % 8 ) ) );
+
+	ReleaseRegion(p, slab);
+}
+
+// Description :
+// Check if there are still head room in a used region beyond size bytes
+// that can be split to allow new allocation between this and the next
+// region. Determined by asset sizes. The tail is merged with the next
+// region should that one be free.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ReleaseTail( Page* p, MetaData* block, std::size_t size )
+{
+	std::size_t headroom = ( block->Size - size );
+
+	if ( headroom <= sizeof(MetaData) || headroom - sizeof(MetaData) <= FragmentThreshold(size) || headroom - sizeof(MetaData) < MIN_BLOCK_SIZE )
+		return;
+
+	MetaData* newMetaData = reinterpret_cast<MetaData*>( reinterpret_cast<char*>(block) + sizeof(MetaData) + size );
+	
+	// cast the remainder headroom memory into a new memory set
+	// available for future allocation
+	block->Size = size;
+	// new memory available will be headroom minus the meta data 
+	// that describe the new free space
+	newMetaData->Size = headroom - sizeof(MetaData);
+	newMetaData->prevAvailable = false;
+
+	p->memLeft += newMetaData->Size;
+
+	MetaData* next = NextBlock(p, newMetaData);
+
+	if ( next && next->available )
+	{
+		RemoveFreeBlock(p, next);
+
+		newMetaData->Size += next->Size + sizeof(MetaData);
+
+		p->memLeft += sizeof(MetaData);
+	}
+
+	InsertFreeBlock(p, newMetaData);
+}
+
+// Description :
+// First aligned address in a region that is either its start or leaves
+// enough room before it for a free region of its own
+template <class FitPolicy, class PageSourcePolicy>
+std::uintptr_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AlignedPayload( MetaData* block, unsigned alignment )
+{
+	std::uintptr_t payload = reinterpret_cast<std::uintptr_t>(block) + sizeof(MetaData);
+	std::uintptr_t aligned = ( payload + alignment - 1 ) & ~static_cast<std::uintptr_t>( alignment - 1 );
+
+	while ( aligned != payload && aligned - payload < sizeof(MetaData) + MIN_BLOCK_SIZE )
+		aligned += alignment;
+
+	return aligned;
+}
+
+// Description :
+// Move the start of a free region up to the first aligned address that
+// leaves enough room before it for a free region of its own, then carve
+// the aligned part as usual.
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::CarveAlignedBlock( Page* p, MetaData* block, std::size_t size, unsigned alignment )
+{
+	std::uintptr_t payload = reinterpret_cast<std::uintptr_t>(block) + sizeof(MetaData);
+	std::uintptr_t aligned = AlignedPayload(block, alignment);
+
+	if ( aligned == payload )
+		return CarveBlock(p, block, size);
+
+	// an empty page is about to receive its first allocation
+	if ( p->memLeft == pageCapacity )
+		--emptyPageCount;
+
+	unsigned lead = static_cast<unsigned>( aligned - payload );
+	MetaData* alignedMetaData = reinterpret_cast<MetaData*>( aligned - sizeof(MetaData) );
+
+	// the leading padding stays behind as a free region
+	alignedMetaData->Size = block->Size - lead;
+	alignedMetaData->available = false;
+	block->Size = lead - sizeof(MetaData);
+
+	InsertFreeBlock(p, block);
+
+	p->memLeft -= sizeof(MetaData);
+
+	return CarveBlock(p, alignedMetaData, size);
+}
+
+// Description :
+// Rounds up without adding to the size, which could wrap around
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::RoundToGranules( std::size_t size )
+{
+	std::size_t count = size / GRANULE_SIZE + ( 0 != size % GRANULE_SIZE ? 1 : 0 );
+
+	return count ? count : 1;
+}
+
+// Description :
+// First fit over the used granule bitmap. Runs are measured a word at a
+// time: the next free granule and the used granule ending its run are each
+// one bit scan away, so a candidate costs a couple of scans no matter how
+// long it is, and used or free stretches are skipped whole.
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::FindGranuleRun( Page* p, std::size_t count, std::size_t step ) const
+{
+	std::size_t first = 0;
+
+	for ( ;; )
+	{
+		first = NextClearBit(p->usedMap, first, granuleWords);
+
+		// next multiple of step at or past the free granule
+		first = ( first + step - 1 ) / step * step;
+
+		if ( first + count > granuleCount )
+			return granuleCount;
+
+		std::size_t used = NextSetBit(p->usedMap, first, granuleWords);
+
+		if ( used >= first + count )
+			return first;
+
+		first = used + 1;
+	}
+}
+
+// Description :
+// Pages whose longest free run is known to be too short are skipped
+// by the page index without looking at their bitmap. A failed search 
+// of a whole page tightens that bound, so the same page is not searched 
+// in vain twice.
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AcquireGranules( std::size_t count, std::size_t step, Page*& page )
+{
+	for ( Page* p = FindPage(count, 0); p; p = FindPage(count, p->slot + 1) )
+	{
+		std::size_t first = FindGranuleRun(p, count, step);
+
+		if ( first < granuleCount )
+		{
+			page = p;
+			return first;
+		}
+
+		// an aligned search may have missed runs that are long enough
+		if ( 1 == step )
+		{
+			p->longestRun = count - 1;
+			UpdatePageIndex(p);
+		}
+	}
+
+	RequestPage();
+
+	page = lastPage;
+	return FindGranuleRun(lastPage, count, step);
+}
+
+// Description :
+// Mark the granules as used and the last one as the end of the region
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::CarveGranules( Page* p, std::size_t first, std::size_t count )
+{
+	// an empty page is about to receive its first allocation
+	if ( p->memLeft == pageCapacity )
+		--emptyPageCount;
+
+	SetBits(p->usedMap, first, count);
+	SetBits(p->endMap, first + count - 1, 1);
+
+	p->memLeft -= count * GRANULE_SIZE;
+
+	return p->chunk + first * GRANULE_SIZE;
+}
+
+// Description :
+// The mapping is aligned like a chunk and starts with a page header
+// without owner, followed by the large object header. The memory comes
+// right after, aligned as requested, so masking its address always
+// lands on the page header.
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AllocateLarge( std::size_t size, unsigned alignment )
+{
+	if ( alignment < sizeof(void*) )
+		alignment = sizeof(void*);
+
+	// failures show up in the stats, the caller gets nullptr
+	if ( alignment >= pageAlignment )
+	{
+		++stats.largeObjectFailures;
+		return nullptr;
+	}
+
+	std::size_t offset = ( sizeof(PageHeader) + sizeof(LargeObject) + alignment - 1 ) & ~static_cast<std::size_t>( alignment - 1 );
+	std::size_t systemPage = PageSource::SystemPageSize();
+
+	// no mapping can hold it, and the length would wrap around
+	if ( size > ~static_cast<std::size_t>(0) - offset - systemPage )
+	{
+		++stats.largeObjectFailures;
+		return nullptr;
+	}
+
+	std::size_t length = ( offset + size + systemPage - 1 ) & ~( systemPage - 1 );
+
+	char* chunk = static_cast<char*>( largeSource.Acquire(length, pageAlignment) );
+
+	if ( nullptr == chunk )
+	{
+		++stats.largeObjectFailures;
+		return nullptr;
+	}
+
+	reinterpret_cast<PageHeader*>(chunk)->owner = nullptr;
+	reinterpret_cast<PageHeader*>(chunk)->manager = this;
+
+	LargeObject* large = reinterpret_cast<LargeObject*>( chunk + sizeof(PageHeader) );
+
+	large->length = length;
+	large->usable = length - offset;
+	large->serial = largeSerial++;
+	large->Prev = nullptr;
+	large->Next = largeObjects;
+
+	if ( largeObjects )
+		largeObjects->Prev = large;
+
+	largeObjects = large;
+
+	++stats.largeObjectMaps;
+
+	return chunk + offset;
+}
+
+// Description :
+// Pages are always owned, only a large object mapping leaves its owner empty
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::LargeObject* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::LargeFromAddress( void* object ) const
+{
+	std::uintptr_t base = reinterpret_cast<std::uintptr_t>(object) & ~static_cast<std::uintptr_t>( pageAlignment - 1 );
+
+	if ( reinterpret_cast<PageHeader*>(base)->owner )
+		return nullptr;
+
+	return reinterpret_cast<LargeObject*>( base + sizeof(PageHeader) );
+}
+
+// Description :
+// Unlink the large object and unmap it right away
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ReleaseLarge( LargeObject* large )
+{
+	if ( large->Prev )
+		large->Prev->Next = large->Next;
+	else
+		largeObjects = large->Next;
+
+	if ( large->Next )
+		large->Next->Prev = large->Prev;
+
+	largeSource.Release(reinterpret_cast<char*>(large) - sizeof(PageHeader), large->length);
+}
+
+// Description :
+// Bump the memory off the front of what is left of the arena page.
+// What does not fit is skipped until the next rollback, and the next
+// page is requested only when there is none after the arena page yet.
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AllocateLinear( std::size_t size, unsigned alignment )
+{
+	if ( alignment < sizeof(void*) )
+		alignment = sizeof(void*);
+
+	// the worst case is the padding an empty page needs, taken off the
+	// capacity since adding it to the size wraps for the largest sizes
+	if ( alignment - 1 > pageCapacity || size > pageCapacity - ( alignment - 1 ) ) 
+		return AllocateLarge(size, alignment);
+
+	for ( ;; )
+	{
+		char* end = arenaPage->chunk + pageSize;
+		std::uintptr_t top = reinterpret_cast<std::uintptr_t>(end) - arenaPage->memLeft;
+		std::uintptr_t aligned = ( top + alignment - 1 ) & ~static_cast<std::uintptr_t>( alignment - 1 );
+
+		if ( aligned + size <= reinterpret_cast<std::uintptr_t>(end) )
+		{
+			// an empty page is about to receive its first allocation
+			if ( arenaPage->memLeft == pageCapacity )
+				--emptyPageCount;
+
+			arenaPage->memLeft = reinterpret_cast<std::uintptr_t>(end) - aligned - size;
+
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		if ( nullptr == arenaPage->Next )
+			RequestPage();
+
+		arenaPage = arenaPage->Next;
+	}
+}
+
+// Description :
+// Chunks are aligned to pageAlignment, so an aligned granule index
+// is an aligned address
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AllocateFromBitmap( std::size_t size, unsigned alignment )
+{
+	std::size_t step = alignment > GRANULE_SIZE ? alignment / GRANULE_SIZE : 1;
+
+	// too large for a page, checked before the size is rounded to granules
+	if ( size > pageCapacity ) 
+		return AllocateLarge(size, alignment);
+
+	std::size_t count = RoundToGranules(size);
+
+	if ( step + count > granuleCount ) 
+		return AllocateLarge(size, alignment);
+
+	Page* p = nullptr;
+	std::size_t first = AcquireGranules(count, step, p);
+
+	return CarveGranules(p, first, count);
+}
+
+// Description :
+// Shrinking moves the end bit back, growing takes over the granules
+// right after the region when they are all free. Only when neither
+// works is the memory moved.
+template <class FitPolicy, class PageSourcePolicy>
+void* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ReallocateGranules( Page* p, void* object, std::size_t size )
+{
+	std::size_t first = ( static_cast<char*>(object) - p->chunk ) / GRANULE_SIZE;
+	std::size_t last = LastGranule(p, first);
+	std::size_t count = last - first + 1;
+
+	if ( size <= pageCapacity )
+	{
+		std::size_t needed = RoundToGranules(size);
+
+		if ( needed <= count )
+		{
+			ClearBits(p->usedMap, first + needed, count - needed);
+			ClearBits(p->endMap, last, 1);
+			SetBits(p->endMap, first + needed - 1, 1);
+
+			p->memLeft += ( count - needed ) * GRANULE_SIZE;
+
+			// the released tail may lengthen the free run after it
+			std::size_t runEnd = NextSetBit(p->usedMap, first + needed, granuleWords);
+
+			if ( runEnd - first - needed > p->longestRun )
+			{
+				p->longestRun = runEnd - first - needed;
+				UpdatePageIndex(p);
+			}
+
+			return object;
+		}
+
+		if ( NextSetBit(p->usedMap, last + 1, granuleWords) >= first + needed )
+		{
+			SetBits(p->usedMap, last + 1, needed - count);
+			ClearBits(p->endMap, last, 1);
+			SetBits(p->endMap, first + needed - 1, 1);
+
+			p->memLeft -= ( needed - count ) * GRANULE_SIZE;
+			return object;
+		}
+	}
+
+	void* moved = AllocateObject(size);
+
+	if ( nullptr == moved )
+		return nullptr;
+
+	memcpy(moved, object, count * GRANULE_SIZE);
+	FreeObject(object);
+
+	return moved;
+}
+
+// Description :
+// The end of a region is the first end bit at or after its first granule
+template <class FitPolicy, class PageSourcePolicy>
+std::size_t BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::LastGranule( Page* p, std::size_t first ) const
+{
+	return NextSetBit(p->endMap, first, granuleWords);
+}
+
+// Description :
+// Free granules are merged with their free neighbours by nature,
+// so releasing a region is a matter of clearing its bits
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ReleaseGranules( Page* p, void* object )
+{
+	std::size_t first = ( static_cast<char*>(object) - p->chunk ) / GRANULE_SIZE;
+	std::size_t last = LastGranule(p, first);
+
+	ClearBits(p->usedMap, first, last - first + 1);
+	ClearBits(p->endMap, last, 1);
+
+	p->memLeft += ( last - first + 1 ) * GRANULE_SIZE;
+
+	// the released granules join the free runs on either side
+	std::size_t runStart = PrevSetBit(p->usedMap, first - 1) + 1;
+	std::size_t runEnd = NextSetBit(p->usedMap, last + 1, granuleWords);
+
+	if ( runEnd - runStart > p->longestRun )
+	{
+		p->longestRun = runEnd - runStart;
+		UpdatePageIndex(p);
+	}
+
+	if ( p->memLeft == pageCapacity )
+		++emptyPageCount;
+}
+
+// Description :
+// Dispatch on the layout
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::ReleaseRegion( Page* p, void* object )
+{
+	if ( LAYOUT_BITMAP == layout )
+		ReleaseGranules(p, object);
+	else
+		ReleaseBlock(p, reinterpret_cast<MetaData*>( reinterpret_cast<char*>(object) - sizeof(MetaData) ));
+}
+
+// Description :
+// Regions are laid out back to back up to the end of the chunk
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::MetaData* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::NextBlock( Page* p, MetaData* block ) const
+{
+	char* next = reinterpret_cast<char*>(block) + sizeof(MetaData) + block->Size;
+
+	return next < p->chunk + pageSize ? reinterpret_cast<MetaData*>(next) : nullptr;
+}
+
+// Description :
+// Step back over the free region using the size stored in its last word
+template <class FitPolicy, class PageSourcePolicy>
+typename BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::MetaData* BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::PrevBlock( MetaData* block )
+{
+	std::size_t prevSize = *reinterpret_cast<std::size_t*>( reinterpret_cast<char*>(block) - sizeof(std::size_t) );
+
+	return reinterpret_cast<MetaData*>( reinterpret_cast<char*>(block) - prevSize - sizeof(MetaData) );
+}
+
+// Description :
+// Clear the availability flag of a region and the copy held by its successor
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::MarkUsed( Page* p, MetaData* block )
+{
+	block->available = false;
+	block->movable = false;
+
+	if ( MetaData* next = NextBlock(p, block) )
+		next->prevAvailable = false;
+}
+
+// Description :
+// Push a free region to the head of the list of its size class
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::InsertFreeBlock( Page* p, MetaData* block )
+{
+	unsigned fl = HighestBit(block->Size);
+	unsigned sl = static_cast<unsigned>( block->Size >> ( fl - SL_LOG2 ) ) & ( SL_COUNT - 1 );
+
+	FreeLinks* links = reinterpret_cast<FreeLinks*>( reinterpret_cast<char*>(block) + sizeof(MetaData) );
+	MetaData* head = p->freeLists[fl][sl];
+
+	links->PrevFree = nullptr;
+	links->NextFree = head;
+
+	if ( head )
+		reinterpret_cast<FreeLinks*>( reinterpret_cast<char*>(head) + sizeof(MetaData) )->PrevFree = block;
+
+	p->freeLists[fl][sl] = block;
+	p->slBitmap[fl] |= 1u << sl;
+	p->flBitmap |= static_cast<std::size_t>(1) << fl;
+
+	block->available = true;
+
+	// the trailing size word lets the next region find this one
+	*reinterpret_cast<std::size_t*>( reinterpret_cast<char*>(block) + sizeof(MetaData) + block->Size - sizeof(std::size_t) ) = block->Size;
+
+	if ( MetaData* next = NextBlock(p, block) )
+		next->prevAvailable = true;
+
+	UpdatePageIndex(p);
+}
+
+// Description :
+// Unlink a free region, clearing the class bits once its list runs empty
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::RemoveFreeBlock( Page* p, MetaData* block )
+{
+	unsigned fl = HighestBit(block->Size);
+	unsigned sl = static_cast<unsigned>( block->Size >> ( fl - SL_LOG2 ) ) & ( SL_COUNT - 1 );
+
+	FreeLinks* links = reinterpret_cast<FreeLinks*>( reinterpret_cast<char*>(block) + sizeof(MetaData) );
+
+	if ( links->PrevFree )
+		reinterpret_cast<FreeLinks*>( reinterpret_cast<char*>(links->PrevFree) + sizeof(MetaData) )->NextFree = links->NextFree;
+	else
+		p->freeLists[fl][sl] = links->NextFree;
+
+	if ( links->NextFree )
+		reinterpret_cast<FreeLinks*>( reinterpret_cast<char*>(links->NextFree) + sizeof(MetaData) )->PrevFree = links->PrevFree;
+
+	if ( nullptr == p->freeLists[fl][sl] )
+	{
+		p->slBitmap[fl] &= ~( 1u << sl );
+
+		if ( 0 == p->slBitmap[fl] )
+			p->flBitmap &= ~( static_cast<std::size_t>(1) << fl );
+	}
+
+	UpdatePageIndex(p);
+}
+
+// Description :
+// Garbage collection at the end of the program lifecycle when the manager's dtor is called
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::FreeAllPages()
+{
+	compactPage = nullptr;
+
+	// iterate throught and delete the memory chunks
+	for ( Page* p = pageList; p != nullptr; p = pageList )
+	{
+		pageList = pageList->Next;
+		
+		if ( p->chunk )
+			FreeChunk(p->chunk);
+
+		delete [] p->slabMap;
+		delete [] p->usedMap;
+
+		if ( p )
+			delete p;
+	}
+}
+
+// Description:
+// Append a record to a snapshot being gathered
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::AppendRecord( std::vector<char>& buffer, const void* record, std::size_t size )
+{
+	const char* bytes = static_cast<const char*>(record);
+
+	buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+// Description:
+// A binary snapshot to examine the memory for debugging purpose.
+// Regions are read off the boundary tags or the granule bitmaps,
+// the whole snapshot is put together first and written at once.
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::MemoryDump(const char* fileName, bool withContents)
+{
+	std::vector<char> buffer;
+	buffer.reserve( sizeof(SnapshotHeader) + pageCount * ( sizeof(SnapshotPage) + ( withContents ? pageSize : 0 ) ) );
+
+	SnapshotHeader header;
+	memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+	header.version = SNAPSHOT_FORMAT_VERSION;
+	header.flags = withContents ? SNAPSHOT_CONTENTS : SNAPSHOT_BLOCK_MAP;
+	header.layout = layout;
+	header.pageSize = pageSize;
+	header.pageCount = pageCount;
+
+	AppendRecord(buffer, &header, sizeof(header));
+
+	std::cout << "Writing file: " << fileName << std::endl;
+
+	for ( Page* p = pageList; p; p = p->Next )
+	{
+		// the region count is patched in once the regions are known
+		std::size_t pageRecord = buffer.size();
+
+		SnapshotPage page;
+		page.base = reinterpret_cast<std::uintptr_t>(p->chunk);
+		page.memLeft = p->memLeft;
+		page.regionCount = 0;
+		page.reserved = 0;
+
+		AppendRecord(buffer, &page, sizeof(page));
+
+		SnapshotRegion region;
+		region.reserved = 0;
+
+		if ( LAYOUT_BITMAP == layout )
+		{
+			std::size_t g = ( sizeof(PageHeader) + GRANULE_SIZE - 1 ) / GRANULE_SIZE;
+
+			while ( g < granuleCount )
+			{
+				bool used = TestBit(p->usedMap, g);
+				std::size_t end = used ? LastGranule(p, g) + 1 : NextSetBit(p->usedMap, g, granuleWords);
+
+				if ( end > granuleCount )
+					end = granuleCount;
+
+				region.offset = g * GRANULE_SIZE;
+				region.size = ( end - g ) * GRANULE_SIZE;
+				region.flags = used ? SNAPSHOT_REGION_USED : SNAPSHOT_REGION_AVAILABLE;
+
+				if ( used && SlabFromAddress(p, p->chunk + region.offset) )
+					region.flags |= SNAPSHOT_REGION_SLAB;
+
+				AppendRecord(buffer, &region, sizeof(region));
+				++page.regionCount;
+
+				g = end;
+			}
+		}
+		else if ( LAYOUT_LINEAR == layout )
+		{
+			// the arena knows no regions, only the used front of the page
+			std::uint64_t used = pageCapacity - p->memLeft;
+
+			region.offset = sizeof(PageHeader);
+			region.size = used;
+			region.flags = SNAPSHOT_REGION_USED;
+
+			if ( used )
+			{
+				AppendRecord(buffer, &region, sizeof(region));
+				++page.regionCount;
+			}
+
+			region.offset += used;
+			region.size = p->memLeft;
+			region.flags = SNAPSHOT_REGION_AVAILABLE;
+
+			if ( p->memLeft )
+			{
+				AppendRecord(buffer, &region, sizeof(region));
+				++page.regionCount;
+			}
+		}
+		else
+		{
+			for ( MetaData* meta = reinterpret_cast<MetaData*>(p->chunk + sizeof(PageHeader)); meta; meta = NextBlock(p, meta) )
+			{
+				char* data = reinterpret_cast<char*>(meta) + sizeof(MetaData);
+
+				region.offset = static_cast<std::uint64_t>( data - p->chunk );
+				region.size = meta->Size;
+				region.flags = meta->available ? SNAPSHOT_REGION_AVAILABLE : SNAPSHOT_REGION_USED;
+
+				if ( !meta->available && SlabFromAddress(p, data) )
+					region.flags |= SNAPSHOT_REGION_SLAB;
+
+				AppendRecord(buffer, &region, sizeof(region));
+				++page.regionCount;
+			}
+		}
+
+		memcpy(&buffer[pageRecord], &page, sizeof(page));
+
+		if ( withContents )
+			AppendRecord(buffer, p->chunk, pageSize);
+	}
+
+	std::ofstream dumpFile(fileName, std::ios::binary);
+
+	dumpFile.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	dumpFile.close();
+}
+
+// Description:
+// The header carries the configuration, so a replay
+// knows what the trace was captured with
+template <class FitPolicy, class PageSourcePolicy>
+bool BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::StartTrace( const char* fileName )
+{
+	StopTrace();
+
+	TraceHeader header;
+	header.pageSize = pageSize;
+	header.fragmentThreshold = fragmentThreshold;
+	header.layout = layout;
+
+	trace = new TraceWriter(fileName, header);
+
+	if ( !trace->IsOpen() )
+	{
+		std::cout << "Cannot open trace file: " << fileName << std::endl;
+		StopTrace();
+		return false;
+	}
+
+	return true;
+}
+
+// Description:
+// Write out and close the running trace
+template <class FitPolicy, class PageSourcePolicy>
+void BasicVariableMemoryManager<FitPolicy, PageSourcePolicy>::StopTrace()
+{
+	delete trace;
+	trace = nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,191 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 Xavier RX Tan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in the
+Software without restriction, including without limitation the rights to use, copy,
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the
+following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/****************************************************
+Author : Xavier Tan
+Email  : xavier.rx.tan@gmail.com / tan.ruixiang@digipen.edu
+
+MemoryResource.h
+
+*****************************************************/
+#ifndef MEMORY_RESOURCE_H_
+#define MEMORY_RESOURCE_H_
+
+#include "MemoryManager.h"
+
+#include <cstddef>
+#include <new>
+
+// std::pmr needs C++17, MSVC only reports it through _MSVC_LANG
+#if defined(_MSVC_LANG) && _MSVC_LANG > __cplusplus
+#define MEMORY_MANAGER_CPLUSPLUS _MSVC_LANG
+#else
+#define MEMORY_MANAGER_CPLUSPLUS __cplusplus
+#endif
+
+#if MEMORY_MANAGER_CPLUSPLUS >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define MEMORY_MANAGER_HAS_PMR 1
+#endif
+#endif
+
+/**
+	\brief 
+		A stateful STL allocator drawing from a manager, so standard containers grow 
+		in its pages instead of the global heap. Copies, rebound ones included, share 
+		the manager and compare equal as long as they do. Types aligned past a pointer 
+		get their alignment through AllocateAligned.
+	\tparam T		The type allocated
+	\tparam Manager	A BasicVariableMemoryManager, VariableMemoryManager by default
+*/
+template <class T, class Manager = VariableMemoryManager>
+class ManagerAllocator
+{
+public:
+	typedef T value_type;
+
+	/**
+		\brief Rebinds the allocator to another type, as containers do for their nodes
+	*/
+	template <class U>
+	struct rebind
+	{
+		typedef ManagerAllocator<U, Manager> other;
+	};
+
+	/**
+		\brief Constructor
+		\param _manager The manager the memory comes from. It must outlive every container using the allocator.
+	*/
+	explicit ManagerAllocator( Manager& _manager ) : manager(&_manager) {}
+
+	/**
+		\brief Converting constructor, the rebound allocator shares the manager
+	*/
+	template <class U>
+	ManagerAllocator( const ManagerAllocator<U, Manager>& other ) : manager(&other.GetManager()) {}
+
+	/**
+		\brief Memory for count objects of type T. Throws std::bad_array_new_length when count 
+			   is past max_size, and std::bad_alloc when the manager fails.
+	*/
+	T* allocate( std::size_t count )
+	{
+		if ( count > max_size() )
+			throw std::bad_array_new_length();
+
+		void* memory = manager->AllocateAligned( count * sizeof(T), static_cast<unsigned>(alignof(T)) );
+
+		if ( nullptr == memory )
+			throw std::bad_alloc();
+
+		return static_cast<T*>(memory);
+	}
+
+	/**
+		\brief Release memory from allocate. The manager knows the size, so count is not needed.
+	*/
+	void deallocate( T* object, std::size_t /*count*/ )
+	{
+		if ( object )
+			manager->Free(object);
+	}
+
+	/**
+		\brief Largest count allocate takes, beyond it the size in bytes does not fit a size_t
+	*/
+	std::size_t max_size() const { return ~static_cast<std::size_t>(0) / sizeof(T); }
+
+	/**
+		\brief Accessor
+	*/
+	Manager& GetManager() const { return *manager; }
+
+private:
+	Manager* manager;	/**< the manager the memory comes from*/
+};
+
+template <class T, class U, class Manager>
+bool operator== ( const ManagerAllocator<T, Manager>& lhs, const ManagerAllocator<U, Manager>& rhs )
+{
+	return &lhs.GetManager() == &rhs.GetManager();
+}
+
+template <class T, class U, class Manager>
+bool operator!= ( const ManagerAllocator<T, Manager>& lhs, const ManagerAllocator<U, Manager>& rhs )
+{
+	return !( lhs == rhs );
+}
+
+#if defined(MEMORY_MANAGER_HAS_PMR)
+/**
+	\brief 
+		A polymorphic memory resource drawing from a manager, for the std::pmr containers. 
+		Each request gets the alignment it asks for, and two resources are equal when 
+		they share a manager, so memory from one may be released through the other.
+	\tparam Manager	A BasicVariableMemoryManager, VariableMemoryManager by default
+*/
+template <class Manager = VariableMemoryManager>
+class ManagerResource : public std::pmr::memory_resource
+{
+public:
+	/**
+		\brief Constructor
+		\param _manager The manager the memory comes from. It must outlive the resource.
+	*/
+	explicit ManagerResource( Manager& _manager ) : manager(&_manager) {}
+
+	/**
+		\brief Accessor
+	*/
+	Manager& GetManager() const { return *manager; }
+
+private:
+	void* do_allocate( std::size_t bytes, std::size_t alignment ) override
+	{
+		void* memory = manager->AllocateAligned( bytes, static_cast<unsigned>(alignment) );
+
+		if ( nullptr == memory )
+			throw std::bad_alloc();
+
+		return memory;
+	}
+
+	void do_deallocate( void* memory, std::size_t /*bytes*/, std::size_t /*alignment*/ ) override
+	{
+		if ( memory )
+			manager->Free(memory);
+	}
+
+	bool do_is_equal( const std::pmr::memory_resource& other ) const noexcept override
+	{
+		const ManagerResource* resource = dynamic_cast<const ManagerResource*>(&other);
+
+		return resource && resource->manager == manager;
+	}
+
+	Manager* manager;	/**< the manager the memory comes from*/
+};
+#endif
+
+#endif
\ No newline at end of file
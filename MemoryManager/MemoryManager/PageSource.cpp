@@ -0,0 +1,408 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 Xavier RX Tan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in the
+Software without restriction, including without limitation the rights to use, copy,
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the
+following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/****************************************************
+Author : Xavier Tan
+Email  : xavier.rx.tan@gmail.com / tan.ruixiang@digipen.edu
+
+PageSource.cpp
+
+*****************************************************/
+
+#include "PageSource.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Description:
+// Round a length up to a multiple of a power of two
+static std::size_t RoundUp( std::size_t length, std::size_t granularity )
+{
+	return ( length + granularity - 1 ) & ~( granularity - 1 );
+}
+
+// Description:
+// Write one byte per OS page so the whole chunk is faulted in now
+// rather than on first use.
+static void Prefault( void* chunk, std::size_t length )
+{
+	volatile char* bytes = static_cast<char*>(chunk);
+	std::size_t step = PageSource::SystemPageSize();
+
+	for ( std::size_t offset = 0; offset < length; offset += step )
+		bytes[offset] = 0;
+}
+
+#if !defined(_WIN32)
+// Description:
+// Reserve length + alignment bytes of address space without backing and
+// unmap the unaligned head and the tail, leaving an aligned reservation
+// of exactly length bytes for the real mapping to be placed over.
+static void* ReserveAligned( std::size_t length, std::size_t alignment )
+{
+	int reserveFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+	reserveFlags |= MAP_NORESERVE;
+#endif
+
+	std::size_t span = length + alignment;
+	void* raw = mmap(nullptr, span, PROT_NONE, reserveFlags, -1, 0);
+
+	if ( MAP_FAILED == raw )
+		return nullptr;
+
+	std::uintptr_t start = reinterpret_cast<std::uintptr_t>(raw);
+	std::uintptr_t aligned = ( start + alignment - 1 ) & ~static_cast<std::uintptr_t>( alignment - 1 );
+
+	std::size_t head = aligned - start;
+	std::size_t tail = span - head - length;
+
+	if ( head )
+		munmap(raw, head);
+
+	if ( tail )
+		munmap(reinterpret_cast<void*>(aligned + length), tail);
+
+	return reinterpret_cast<void*>(aligned);
+}
+#endif
+
+// Description:
+// Constructor. Huge pages are only ever obtained through a mapping.
+PageSource::PageSource( unsigned _flags )
+		: flags(_flags), mode(PAGE_MODE_NONE)
+{
+	if ( flags & ( PAGE_SOURCE_HUGE_PAGES | PAGE_SOURCE_TRANSPARENT ) )
+		flags |= PAGE_SOURCE_MAPPED;
+}
+
+// Description:
+// Heap chunks come from the aligned C runtime allocator. Mapped chunks
+// first try explicit huge pages if requested, then regular pages with the
+// transparent huge page advice, so a missing huge page pool degrades
+// instead of failing.
+void* PageSource::Acquire( std::size_t size, std::size_t alignment )
+{
+	if ( !( flags & PAGE_SOURCE_MAPPED ) )
+	{
+		void* chunk = nullptr;
+
+#if defined(_WIN32)
+		chunk = _aligned_malloc( size, alignment );
+#else
+		if ( 0 != posix_memalign( &chunk, alignment, size ) )
+			chunk = nullptr;
+#endif
+
+		if ( chunk )
+			RecordMode(PAGE_MODE_HEAP);
+
+		return chunk;
+	}
+
+	std::size_t length = MappedSize(size);
+	std::size_t hugePage = HugePageSize();
+	bool huge = ( flags & PAGE_SOURCE_HUGE_PAGES ) && hugePage && size >= hugePage;
+	bool advise = ( flags & ( PAGE_SOURCE_HUGE_PAGES | PAGE_SOURCE_TRANSPARENT ) ) != 0;
+
+	if ( huge && alignment < hugePage )
+		alignment = hugePage;
+
+#if defined(_WIN32)
+	// there is no transparent huge page advice to give on Windows
+	(void)advise;
+
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	if ( alignment < info.dwAllocationGranularity )
+		alignment = info.dwAllocationGranularity;
+
+	// Windows cannot release part of a reservation, so find an aligned
+	// address in a larger one, release it and claim the aligned part.
+	// Another thread may claim the range in between, hence the retries.
+	for ( unsigned attempt = 0; attempt < 8; ++attempt )
+	{
+		void* raw = VirtualAlloc(nullptr, length + alignment, MEM_RESERVE, PAGE_NOACCESS);
+
+		if ( nullptr == raw )
+			return nullptr;
+
+		std::uintptr_t aligned = ( reinterpret_cast<std::uintptr_t>(raw) + alignment - 1 ) & ~static_cast<std::uintptr_t>( alignment - 1 );
+		VirtualFree(raw, 0, MEM_RELEASE);
+
+		void* chunk = nullptr;
+		PAGE_SOURCE_MODE obtained = PAGE_MODE_MAPPED;
+
+		if ( huge )
+		{
+			chunk = VirtualAlloc(reinterpret_cast<void*>(aligned), length, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+			obtained = PAGE_MODE_EXPLICIT_HUGE;
+
+			if ( chunk )
+				hugeChunks[reinterpret_cast<std::uintptr_t>(chunk)] = length;
+		}
+
+		if ( nullptr == chunk )
+		{
+			chunk = VirtualAlloc(reinterpret_cast<void*>(aligned), length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+			obtained = PAGE_MODE_MAPPED;
+		}
+
+		if ( chunk )
+		{
+			if ( flags & PAGE_SOURCE_PREFAULT )
+				Prefault(chunk, length);
+
+			RecordMode(obtained);
+			return chunk;
+		}
+	}
+
+	return nullptr;
+#else
+	if ( alignment < SystemPageSize() )
+		alignment = SystemPageSize();
+
+	void* base = ReserveAligned(length, alignment);
+
+	if ( nullptr == base )
+		return nullptr;
+
+	int mapFlags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED;
+	int populate = 0;
+
+#if defined(MAP_POPULATE)
+	if ( flags & PAGE_SOURCE_PREFAULT )
+		populate = MAP_POPULATE;
+#endif
+
+#if defined(MAP_HUGETLB)
+	if ( huge )
+	{
+		void* chunk = mmap(base, length, PROT_READ | PROT_WRITE, mapFlags | MAP_HUGETLB | populate, -1, 0);
+
+		if ( MAP_FAILED != chunk )
+		{
+			hugeChunks[reinterpret_cast<std::uintptr_t>(chunk)] = length;
+
+			RecordMode(PAGE_MODE_EXPLICIT_HUGE);
+			return chunk;
+		}
+	}
+#endif
+
+	// the huge page advice has to be given before the memory is touched,
+	// so prefaulting is done by hand afterwards in that case
+	void* chunk = mmap(base, length, PROT_READ | PROT_WRITE, mapFlags | ( advise ? 0 : populate ), -1, 0);
+
+	if ( MAP_FAILED == chunk )
+	{
+		munmap(base, length);
+		return nullptr;
+	}
+
+	PAGE_SOURCE_MODE obtained = PAGE_MODE_MAPPED;
+
+#if defined(MADV_HUGEPAGE)
+	if ( advise && 0 == madvise(chunk, length, MADV_HUGEPAGE) )
+		obtained = PAGE_MODE_TRANSPARENT_HUGE;
+#endif
+
+	if ( advise && ( flags & PAGE_SOURCE_PREFAULT ) )
+		Prefault(chunk, length);
+
+	RecordMode(obtained);
+	return chunk;
+#endif
+}
+
+// Description:
+// Hand a chunk back the same way it was obtained
+void PageSource::Release( void* chunk, std::size_t size )
+{
+	if ( !( flags & PAGE_SOURCE_MAPPED ) )
+	{
+#if defined(_WIN32)
+		_aligned_free( chunk );
+#else
+		free( chunk );
+#endif
+		return;
+	}
+
+	hugeChunks.erase(reinterpret_cast<std::uintptr_t>(chunk));
+
+#if defined(_WIN32)
+	(void)size;
+	VirtualFree(chunk, 0, MEM_RELEASE);
+#else
+	munmap(chunk, MappedSize(size));
+#endif
+}
+
+// Description:
+// MADV_DONTNEED drops the pages at once and maps zero pages back in on
+// the next touch. MEM_RESET is the closest Windows gets without having
+// to commit the memory again before touching it. Explicit huge pages
+// are decided per chunk, a source may hold them next to fallback chunks.
+bool PageSource::Decommit( void* memory, std::size_t size )
+{
+	if ( !( flags & PAGE_SOURCE_MAPPED ) || InHugeChunk(reinterpret_cast<std::uintptr_t>(memory)) )
+		return false;
+
+	std::size_t systemPage = SystemPageSize();
+	std::uintptr_t begin = RoundUp(reinterpret_cast<std::uintptr_t>(memory), systemPage);
+	std::uintptr_t end = ( reinterpret_cast<std::uintptr_t>(memory) + size ) & ~static_cast<std::uintptr_t>( systemPage - 1 );
+
+	if ( end <= begin )
+		return true;
+
+#if defined(_WIN32)
+	return nullptr != VirtualAlloc(reinterpret_cast<void*>(begin), end - begin, MEM_RESET, PAGE_READWRITE);
+#else
+	return 0 == madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+#endif
+}
+
+// Description:
+// Accessor
+PAGE_SOURCE_MODE PageSource::Mode() const
+{
+	return mode;
+}
+
+// Description:
+// Accessor
+unsigned PageSource::Flags() const
+{
+	return flags;
+}
+
+// Description:
+// Ask the system for the size of a regular page
+static std::size_t QuerySystemPageSize()
+{
+#if defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+#else
+	return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// Description:
+// Windows reports the large page size directly, Linux through the
+// Hugepagesize line of /proc/meminfo
+static std::size_t QueryHugePageSize()
+{
+	std::size_t hugePageSize = 0;
+
+#if defined(_WIN32)
+	hugePageSize = GetLargePageMinimum();
+#else
+	if ( FILE* meminfo = fopen("/proc/meminfo", "r") )
+	{
+		char line[128];
+		unsigned long kiloBytes = 0;
+
+		while ( fgets(line, sizeof(line), meminfo) )
+		{
+			if ( 1 == sscanf(line, "Hugepagesize: %lu kB", &kiloBytes) )
+			{
+				hugePageSize = static_cast<std::size_t>(kiloBytes) * 1024;
+				break;
+			}
+		}
+
+		fclose(meminfo);
+	}
+#endif
+
+	return hugePageSize;
+}
+
+// Description:
+// Queried once, the value never changes for the life of the process.
+// The local static is initialized thread safely, threads of 
+// ConcurrentMemoryManager may get here at the same time.
+std::size_t PageSource::SystemPageSize()
+{
+	static const std::size_t pageSize = QuerySystemPageSize();
+
+	return pageSize;
+}
+
+// Description:
+// Same as SystemPageSize
+std::size_t PageSource::HugePageSize()
+{
+	static const std::size_t hugePageSize = QueryHugePageSize();
+
+	return hugePageSize;
+}
+
+// Description:
+// Explicit huge page mappings must span whole huge pages, everything
+// else whole OS pages. Acquire and Release agree on the length this way
+// without the manager having to remember it.
+std::size_t PageSource::MappedSize( std::size_t size ) const
+{
+	std::size_t granularity = SystemPageSize();
+	std::size_t hugePage = HugePageSize();
+
+	if ( ( flags & PAGE_SOURCE_HUGE_PAGES ) && hugePage && size >= hugePage )
+		granularity = hugePage;
+
+	return RoundUp(size, granularity);
+}
+
+// Description:
+// The chunk starting last at or before the address is the only candidate
+bool PageSource::InHugeChunk( std::uintptr_t address ) const
+{
+	std::map<std::uintptr_t, std::size_t>::const_iterator chunk = hugeChunks.upper_bound(address);
+
+	if ( hugeChunks.begin() == chunk )
+		return false;
+
+	--chunk;
+
+	return address < chunk->first + chunk->second;
+}
+
+// Description:
+// Keep the weakest backing seen so a single fallback is not hidden
+void PageSource::RecordMode( PAGE_SOURCE_MODE obtained )
+{
+	if ( PAGE_MODE_NONE == mode || obtained < mode )
+		mode = obtained;
+}
\ No newline at end of file
@@ -0,0 +1,150 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 Xavier RX Tan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in the
+Software without restriction, including without limitation the rights to use, copy,
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the
+following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/****************************************************
+Author : Xavier Tan
+Email  : xavier.rx.tan@gmail.com / tan.ruixiang@digipen.edu
+
+PageSource.h
+
+*****************************************************/
+#ifndef PAGE_SOURCE_H_
+#define PAGE_SOURCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+/**
+	\enum PAGE_SOURCE_FLAGS
+	\brief 
+		Where page memory comes from and how it is backed. Flags may be combined.
+*/
+enum PAGE_SOURCE_FLAGS
+{
+	PAGE_SOURCE_HEAP		 = 0,		/**< aligned blocks of the C runtime heap*/
+	PAGE_SOURCE_MAPPED		 = 1 << 0,	/**< anonymous mappings straight from the OS (mmap / VirtualAlloc)*/
+	PAGE_SOURCE_HUGE_PAGES	 = 1 << 1,	/**< ask for explicit huge pages (MAP_HUGETLB / MEM_LARGE_PAGES), implies PAGE_SOURCE_MAPPED*/
+	PAGE_SOURCE_TRANSPARENT	 = 1 << 2,	/**< advise transparent huge pages (MADV_HUGEPAGE), also the fallback of PAGE_SOURCE_HUGE_PAGES*/
+	PAGE_SOURCE_PREFAULT	 = 1 << 3	/**< populate the memory up front so the first touch does not fault*/
+};
+
+/**
+	\enum PAGE_SOURCE_MODE
+	\brief 
+		The backing a page source actually obtained from the system
+*/
+enum PAGE_SOURCE_MODE
+{
+	PAGE_MODE_NONE,					/**< nothing has been requested yet*/
+	PAGE_MODE_HEAP,					/**< C runtime heap*/
+	PAGE_MODE_MAPPED,				/**< regular OS pages*/
+	PAGE_MODE_TRANSPARENT_HUGE,		/**< regular OS pages advised for transparent huge pages*/
+	PAGE_MODE_EXPLICIT_HUGE			/**< explicit huge pages*/
+};
+
+/**
+	\brief 
+		Supplies the chunks of memory that VariableMemoryManager turns into pages. 
+		Chunks are always aligned to the requested power of two, which is what 
+		lets the manager find a page from any address inside of it.
+*/
+class PageSource
+{
+public:
+	/**
+		\brief Constructor.
+		\param _flags A combination of PAGE_SOURCE_FLAGS
+	*/
+	explicit PageSource( unsigned _flags = PAGE_SOURCE_HEAP );
+
+	/**
+		\brief Request a chunk of memory
+		\param size		 Size of the chunk in bytes
+		\param alignment Power of two the chunk address must be a multiple of
+		\return The chunk, or nullptr if the system is out of memory
+	*/
+	void* Acquire( std::size_t size, std::size_t alignment );
+
+	/**
+		\brief Give a chunk obtained from Acquire back to the system
+		\param chunk The chunk
+		\param size	 Size the chunk was acquired with
+	*/
+	void  Release( void* chunk, std::size_t size );
+
+	/**
+		\brief Let the system take back the physical memory behind the whole OS pages of a range 
+			   of a mapped chunk, keeping the range mapped. The memory is backed again on first 
+			   touch and its content is lost. Heap chunks and chunks backed by explicit huge pages 
+			   are left alone, whatever the other chunks of the source got.
+		\param memory	Start of the range, rounded up to an OS page
+		\param size	Length of the range, its end is rounded down to an OS page
+		\return Whether the memory was decommitted
+	*/
+	bool  Decommit( void* memory, std::size_t size );
+
+	/**
+		\brief The weakest backing obtained over every Acquire so far. A request for huge 
+			   pages that had to fall back on regular pages for one chunk reports the fallback.
+	*/
+	PAGE_SOURCE_MODE Mode() const;
+
+	/**
+		\brief The flags the source was created with
+	*/
+	unsigned Flags() const;
+
+	/**
+		\brief Size of a regular OS page
+	*/
+	static std::size_t SystemPageSize();
+
+	/**
+		\brief Size of an explicit huge page, 0 when the platform has none
+	*/
+	static std::size_t HugePageSize();
+
+private:
+
+	/**
+		\brief Length of the mapping that backs a chunk of the given size
+	*/
+	std::size_t MappedSize( std::size_t size ) const;
+
+	/**
+		\brief Lower the reported mode to the backing of the latest chunk if it is weaker
+	*/
+	void  RecordMode( PAGE_SOURCE_MODE obtained );
+
+	/**
+		\brief Whether an address lies in a chunk backed by explicit huge pages
+	*/
+	bool  InHugeChunk( std::uintptr_t address ) const;
+
+	unsigned		 flags;		/**< combination of PAGE_SOURCE_FLAGS*/
+	PAGE_SOURCE_MODE mode;		/**< weakest backing obtained so far*/
+
+	std::map<std::uintptr_t, std::size_t> hugeChunks; /**< start and length of the chunks backed by explicit huge pages*/
+};
+
+#endif
\ No newline at end of file
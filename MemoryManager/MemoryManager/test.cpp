@@ -89,27 +89,63 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 *	fragmentation tolerance value for maximum efficiency. It is also recommended that the users find the 
 *	memory size of their smallest asset and use that as the threshold value for VMM.
 *	
+*	StartTrace records every request of such a prototype run to a compact binary trace, and TraceReplay 
+*	replays that trace against a grid of page sizes, fragment thresholds and policies, reporting the pages 
+*	and memory each one needed and how long the replay took.
+*	
 *	The value is factored in during allocation to make predictions for potential spatial head room. In
-*	the event when the head room is smaller than the threshold plus the meta data header size(16 bytes), 
+*	the event when the head room is smaller than the threshold plus the meta data header size(a pointer), 
 *	it will be given as extra space to the current requested memory and will be reclaimed upon 
 *	deallocation of the said memory region and coalesced together with neighboring free memory space.
 *	
+*	A single threshold suits vertices or textures, rarely both. SetAdaptiveThreshold has the VMM keep a 
+*	running histogram of the request sizes instead, and split headroom off only when it would fit a fair 
+*	share of the requests or another request of the same power of two, per power of two of the request. 
+*	Headroom too small for any request stays with the request rather than lingering as an unusable sliver.
+*	
 *	In order to keep the arbiter memory footprint as small and fast as possible, the meta data header 
-*	are aligned contiguously with the requested memory region. This meta data header contain the 
-*	following information:
+*	are aligned contiguously with the requested memory region. This meta data header is a single pointer 
+*	sized boundary tag that packs the following information:
 *	- size of the memory of this sub-portion
-*	- a pointer to the next meta data header
-*	- a pointer to the previous meta data header
-*	- an unsigned short index to indicate which page this memory resides in
-*	- a Boolean value that indicates if this region is available for writing
-*	- a 1 byte padding for easier memory pointer jump.
+*	- a flag that indicates if this region is available for writing
+*	- a flag that indicates if the region right before this one is available
+*	- a flag that indicates if the region may be moved by Compact
 *	
 *	The size variable is the total value of memory given to the user upon memory request. That includes 
-*	any form of extra fragmentation head rooms for easier reclamation. The next and previous pointers help to 
-*	facilitate fast memory coalescing. The availability Boolean help us skip regions that are not relevant 
-*	for the allocation process. The page index help us to locate the right page index to update another 
-*	meta header for the amount of memory left in a given chunk. However, this is currently an oversight 
-*	in design as the document will process to explain later.
+*	any form of extra fragmentation head rooms for easier reclamation. Regions lie back to back, so the 
+*	next region is found by skipping over the memory of the current one. A free region also repeats its 
+*	size in its last word, which lets the region after it step back to it when coalescing. Used regions 
+*	need no such trailer, so their whole memory belongs to the user. The availability flag help us skip 
+*	regions that are not relevant for the allocation process. 
+*	
+*	Every chunk is aligned to the smallest power of two that covers the page size and starts with a small 
+*	page header pointing back at the page meta header. Masking a memory address handed out by the VMM thus 
+*	lands on that page header, so the amount of memory left in a given chunk is updated in constant time 
+*	no matter how many pages have been requested.
+*	
+*	Chunks are supplied by a PageSource. By default they come from the aligned C runtime heap, which suits 
+*	small pages. Large pages are better served by PAGE_SOURCE_MAPPED, which maps them straight from the OS 
+*	so they are page aligned and can be unmapped. On top of that, PAGE_SOURCE_HUGE_PAGES asks for explicit 
+*	huge pages and falls back on transparent huge pages, cutting TLB misses when streamed vertex buffers are 
+*	walked, and PAGE_SOURCE_PREFAULT faults the whole chunk in up front. GetPageSourceMode reports which 
+*	backing was actually obtained.
+*	
+*	Free regions are additionally threaded through segregated free lists, one set per page. The lists are
+*	indexed by a two level size class (a power of two, split linearly into 4 sub-classes) with a bitmap per
+*	level, so a page can tell in constant time whether it holds a region large enough for a request. The list
+*	links are stored in the first bytes of the free region itself, which is why every allocation is at least
+*	3 pointers long, room for the links and the trailing size. Within a page the largest populated class is chosen to stay close to worst-fit placement.
+*	
+*	Pages themselves are picked through a tournament tree over the page list, each leaf holding the size of 
+*	the region its page would hand out and each node the larger of its two children. The first page that can 
+*	serve a request is found in O(log P), so pages that are full or fragmented into small holes are never 
+*	visited, and a free list update only climbs the tree as far as the maximum it changes.
+*	
+*	Placement is a compile time policy of BasicVariableMemoryManager. WorstFit, the default that 
+*	VariableMemoryManager stands for, takes the largest class. BestFit takes the smallest class sure to hold 
+*	the request and FirstFit tries the head of the request's own class before that, both keeping the large 
+*	regions for large requests. NextFit resumes the page search where the last region came from. The page 
+*	source is a policy as well, any type with the members of PageSource the manager calls will do.
 *	
 *	By keeping the meta data header within the page, it helps the VMM achieve a few things.
 *	
@@ -131,14 +167,49 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 *	and deallocation, garbage collection and maximize memory usage for the assets' requirement. However, VMM's 
 *	design is still open to suggestions for any form of improvement.
 *	
+*	To help choosing the page size and the fragmentation threshold from real usage, GetStats reports how many 
+*	allocations, frees and page requests took place, the bytes in use and their peak, the free memory with its 
+*	largest region and the external fragmentation ratio derived from them, along with a histogram of request 
+*	sizes. GetPageMemLeft reports the memory left per page. Building with MEMORY_MANAGER_LATENCY_STATS adds 
+*	histograms of the time stamp counter cycles spent in Allocate and Free, otherwise the timing compiles out.
+*
+*	MemoryDump writes a binary snapshot of the heap, a list of regions per page laid out in HeapSnapshot.h and
+*	optionally the raw page contents, in a single write. SnapshotTool reads it back offline and prints an
+*	occupancy map of every page with its free memory, largest free region and fragmentation, followed by a
+*	histogram of the free region sizes.
+*
 *	\subsection subsec_oversight Oversights
 *	
 *	\subsubsection subsubsec_unused Returning Unused Memory
-*	One of the biggest oversight is the potential of returning unused memory space back to the OS in runtime
-*	when all assets in a page (perhaps for coherency purposes) are deallocated simultaneously. This is clearly 
-*	an oversight because right now with the given design, the VMM have no way of returning unused pages without 
-*	incurring a large overhead. The unsigned short residing within the memory meta header will now need to be 
-*	updated across the board when said event occurs. In the worst case this will result in a O(N^2) update.
+*	One of the biggest oversight used to be the potential of returning unused memory space back to the OS in 
+*	runtime when all assets in a page (perhaps for coherency purposes) are deallocated simultaneously. With the 
+*	page index stored in every meta header, releasing a page meant renumbering every header of every following 
+*	page, in the worst case a O(N^2) update. Now that pages are found through the header at the start of their 
+*	aligned chunk, ReturnUnusedMemory simply unlinks and releases pages whose chunk is a single free region. 
+*	SetTrimPolicy lets Free do the same on its own once more than a high water mark of pages are empty, 
+*	keeping a low water mark of empty pages around to absorb the next level load.
+*	
+*	Unloading a whole level does not need a Free per asset either. Reset turns every page back into a single 
+*	free region in one pass over the pages and keeps them for the next level. Pages beyond a given number 
+*	have their memory decommitted when they are mapped, so they cost address space only until they are 
+*	touched again, and are returned when they come from the heap.
+*	
+*	A request too large for a page no longer fails. It gets a mapping of its own, aligned like a chunk and 
+*	starting with a page header that has no page behind it, which is how Free tells it apart and unmaps it 
+*	right away. GetStats reports how many such mappings are live and how much they map, so pages can be 
+*	sized for the common assets rather than for the rare huge texture.
+*	
+*	Sizes are std::size_t all the way down, from the public interface to the boundary tags, and the free 
+*	lists have a first level class per bit of a size, so 64 bit builds take pages and regions past 4 GB. 
+*	The number of pages is bounded by memory alone since nothing numbers them.
+*	
+*	That only helps when whole pages empty out. Assets scattered across many pages keep all of them alive, 
+*	and new requests keep requesting pages although the memory left in total would suffice. Assets allocated 
+*	with AllocateHandle are reached through a handle table instead of their address, so the VMM may move them. 
+*	Compact slides such regions down over the free regions in front of them so the free memory of a page 
+*	gathers in one region, then empties the sparsest pages into fuller ones for ReturnUnusedMemory to release. 
+*	It stops once its time budget in microseconds is spent and picks up from there on the next call, so it 
+*	can run in the slack at the end of a frame. Pinned handles stay where they are.
 *	
 *	\subsubsection subsub_MT Multithreading allocation. 
 *	The VMM is currently written under the consideration that it is used in a single 
@@ -150,18 +221,69 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 *	the time of writing I am still in the midst of understanding the methodologies of concurrency. Thus, 
 *	this portion is subjected to further revision when a better level of understanding is achieved.
 *	
+*	ConcurrentMemoryManager is a first step in that direction. Rather than sharing one VMM between threads, 
+*	it gives every thread its own VMM and therefore its own pages, found through a thread local cache, so 
+*	allocation and local deallocation stay exactly as cheap as in the single threaded case. Only memory 
+*	released by a thread other than its owner crosses threads: it is pushed on a lock-free stack in the 
+*	owner's VMM, which the owner takes as a whole and releases in one batch on its next allocation or local 
+*	release. Since nodes are never popped one by one, the push is not exposed to the ABA problem. A thread 
+*	that exits drains its VMM, returns its empty pages and leaves it to the next thread that shows up, 
+*	which takes whatever was released into it in the meantime.
+*	
 *	\subsubsection subsubsec_cache Cache Coherency 
 *	One more area of concern may be cache cohenrency. If data set is small then the cache may hit the meta data
 *	when the cache takes one line worth of data.
+*	
+*	Managers constructed with LAYOUT_BITMAP avoid that altogether. Their pages are cut into 16 byte granules 
+*	and every region is a run of whole granules. Which granules are handed out, and which one ends a region, 
+*	is recorded in two bitmaps that live with the page meta header outside the chunk, so user memory holds 
+*	nothing but user data and the search only ever reads the densely packed bitmaps. Runs of free granules 
+*	are measured a word at a time with bit scans, and built with AVX2 enabled the scan crosses 8 fully used 
+*	or fully free words per compare. Regions are placed first 
+*	fit, the fragment threshold plays no part, and freed granules coalesce simply by clearing their bits.
+*	
+*	Per frame and per load temporaries are better served by LAYOUT_LINEAR, which turns the pages into an arena. 
+*	Memory is bumped off the front of the current page and no header is written at all, so Free has nothing to 
+*	do. Instead Mark remembers the page and the memory left in it, and Rollback hands everything allocated since 
+*	back at once by restoring those and emptying the pages that were moved on to since, a cost that depends on 
+*	the pages touched rather than on the allocations. Reset rolls back to the very start.
 */
 
 #include "MemoryManager.h"
+#include "ConcurrentMemoryManager.h"
+#include "AllocationTrace.h"
+#include "HeapSnapshot.h"
+#include "MemoryResource.h"
 
-#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 static VariableMemoryManager TestManager(5 * MEM_SIZE::KILO_BYTE, 50);
 
+// number of checks that did not hold, main fails when there is any
+static unsigned failedChecks = 0;
+
+/*
+*	\brief
+*	Count and report a check that does not hold. The tests keep running so 
+*	every failure shows up, and the process exits with a failure at the end.
+*/
+static bool Check( bool condition, const char* description )
+{
+	if ( !condition )
+	{
+		std::cout << "CHECK FAILED : " << description << std::endl;
+		++failedChecks;
+	}
+
+	return condition;
+}
+
 /*
 *	\brief 
 *	a test structure that is meant to mimic a vertex in a mesh file
@@ -233,37 +355,37 @@ void SequenceCorrectnessTest()
 	// a simple allocation test
 	test_struct* A = new test_struct;
 
-	TestManager.MemoryDump("../1st Write.txt");
+	TestManager.MemoryDump("../1st Write.vmms");
 
 	// An array allocation. Apparently the compiler will
 	// take care of the extra 4, 8 or any other amount of specified alignment
 	// bytes that it will request under the hood
 	test_struct* B = new test_struct[10];
 
-	TestManager.MemoryDump("../2nd Write.txt");
+	TestManager.MemoryDump("../2nd Write.vmms");
 
 	// A deallocation memory test.
 	delete A;
 
-	TestManager.MemoryDump("../1st Delete.txt");
+	TestManager.MemoryDump("../1st Delete.vmms");
 
 	// A test for correctness of memory allocation
 	// pattern
 	test_struct* C = new test_struct[5];
 
-	TestManager.MemoryDump("../3rd Write.txt");
+	TestManager.MemoryDump("../3rd Write.vmms");
 
 	// A mass memory deallocation test.
 	// alignment byte factored in on compiler's end
 	// Also a test on coalescing function correctness
 	delete [] B;
 
-	TestManager.MemoryDump("../2nd Delete.txt");
+	TestManager.MemoryDump("../2nd Delete.vmms");
 
 	// A test on overwriting previously freed memory
 	A = new test_struct[10];
 
-	TestManager.MemoryDump("../4th Write.txt");
+	TestManager.MemoryDump("../4th Write.vmms");
 
 	// same test at a larger scope
 	// and reallcate into a section of coalesced
@@ -273,25 +395,1089 @@ void SequenceCorrectnessTest()
 
 	test_struct* D = new test_struct[10];
 
-	TestManager.MemoryDump("../5th Write.txt");
+	TestManager.MemoryDump("../5th Write.vmms");
 
 	// A test for new page request
 	test_struct* E = new test_struct[3];
 
-	TestManager.MemoryDump("../6th Write.txt");
+	TestManager.MemoryDump("../6th Write.vmms");
 
 	// test to find out if the correct memory region will
 	// be choosen.
 	test_struct* F = new test_struct[2];
 
-	TestManager.MemoryDump("../7th Write.txt");
+	TestManager.MemoryDump("../7th Write.vmms");
+
+	Check(A && B && C && D && E && F, "sequence allocations succeed");
+}
+
+/*
+*	\brief
+*	Fills several pages, frees everything and returns the now empty pages to the system.
+*/
+void ReturnUnusedMemoryTest()
+{
+	VariableMemoryManager manager(MEM_SIZE::KILO_BYTE, 50);
+
+	void* blocks[16];
+
+	for ( unsigned i = 0; i < 16; ++i )
+		blocks[i] = manager.Allocate(400);
+
+	for ( unsigned i = 0; i < 16; ++i )
+		manager.Free(blocks[i]);
+
+	std::size_t released = manager.ReturnUnusedMemory(1);
+
+	std::cout << "Pages released : " << released << std::endl;
+
+	Check(released > 0 && 1 == manager.GetStats().pageCount, "empty pages go back but the one kept");
+
+	// memory is still served after all but one page went back
+	void* block = manager.Allocate(400);
+
+	Check(nullptr != block, "memory is served after releasing pages");
+
+	manager.Free(block);
+}
+
+/*
+*	\brief
+*	Allocates buffers for SIMD kernels on 32 and 64 byte boundaries in between unaligned vertices 
+*	and checks that they come back aligned and can be released like any other memory.
+*/
+void AlignedAllocationTest()
+{
+	VariableMemoryManager manager(16 * MEM_SIZE::KILO_BYTE, 50);
+
+	void* vertex = manager.Allocate(sizeof(test_struct));
+	void* skinning = manager.AllocateAligned(1000, 32);
+	void* upload = manager.AllocateAligned(3000, 64);
+
+	bool aligned = 0 == reinterpret_cast<std::size_t>(skinning) % 32 && 0 == reinterpret_cast<std::size_t>(upload) % 64;
+
+	std::cout << "Aligned allocations : " << ( aligned ? "aligned" : "MISALIGNED" ) << std::endl;
+
+	Check(aligned, "aligned allocations are aligned");
+
+	manager.Free(skinning);
+	manager.Free(vertex);
+	manager.Free(upload);
+}
+
+/*
+*	\brief
+*	Streams assets in through handles and drops most of them, leaving every page sparsely used. 
+*	Compaction in small time slices must keep the contents and the pinned asset in place while 
+*	emptying enough pages to hand back.
+*/
+void HandleCompactionTest()
+{
+	VariableMemoryManager manager(16 * MEM_SIZE::KILO_BYTE, 50);
+
+	VariableMemoryManager::Handle assets[400];
+
+	for ( unsigned i = 0; i < 400; ++i )
+	{
+		assets[i] = manager.AllocateHandle(500);
+		std::memset(manager.Resolve(assets[i]), i % 251, 500);
+	}
+
+	for ( unsigned i = 0; i < 400; ++i )
+	{
+		if ( i % 4 )
+		{
+			manager.FreeHandle(assets[i]);
+			assets[i] = VariableMemoryManager::INVALID_HANDLE;
+		}
+	}
+
+	void* pinned = manager.Pin(assets[200]);
+
+	// no time at all moves nothing, and the slide resumes past a released page
+	std::size_t moved = manager.Compact(0);
+
+	Check(0 == moved, "compaction without time moves nothing");
+
+	manager.ReturnUnusedMemory();
+
+	std::size_t pagesBefore = manager.GetStats().pageCount;
+	unsigned calls = 1;
+
+	for ( std::size_t step = manager.Compact(50); step; step = manager.Compact(50), ++calls )
+		moved += step;
+
+	bool intact = pinned == manager.Resolve(assets[200]);
+
+	for ( unsigned i = 0; i < 400; i += 4 )
+	{
+		unsigned char* asset = static_cast<unsigned char*>(manager.Resolve(assets[i]));
+
+		for ( unsigned j = 0; j < 500; ++j )
+			intact = intact && asset[j] == i % 251;
+	}
+
+	manager.Unpin(assets[200]);
+
+	std::size_t released = manager.ReturnUnusedMemory();
+
+	std::cout << "Compaction moved " << moved << " bytes in " << calls << " calls, contents " << ( intact ? "intact" : "CORRUPTED" ) 
+			  << ", pages released : " << released << " of " << pagesBefore << std::endl;
+
+	Check(intact, "compaction keeps contents and pinned memory");
+	Check(released > 0, "compaction empties pages");
+	Check(nullptr == manager.Pin(VariableMemoryManager::INVALID_HANDLE), "pinning an invalid handle gives nothing");
+
+	manager.Unpin(VariableMemoryManager::INVALID_HANDLE);
+
+	for ( unsigned i = 0; i < 400; i += 4 )
+		manager.FreeHandle(assets[i]);
+}
+
+/*
+*	\brief
+*	Loads a few huge textures into a manager with pages sized for vertices. The textures get 
+*	mappings of their own, which are gone as soon as they are released.
+*/
+void LargeObjectTest()
+{
+	VariableMemoryManager manager(16 * MEM_SIZE::KILO_BYTE, 50);
+
+	void* vertex = manager.Allocate(sizeof(test_struct));
+	void* texture = manager.Allocate(MEM_SIZE::MEGA_BYTE);
+	void* cubeMap = manager.AllocateAligned(6 * 64 * MEM_SIZE::KILO_BYTE, 4096);
+
+	std::memset(texture, 0xAB, MEM_SIZE::MEGA_BYTE);
+	std::memset(cubeMap, 0xCD, 6 * 64 * MEM_SIZE::KILO_BYTE);
+
+	// a streamed buffer outgrowing the page moves to a mapping
+	void* stream = manager.Allocate(8 * MEM_SIZE::KILO_BYTE);
+	stream = manager.Reallocate(stream, 256 * MEM_SIZE::KILO_BYTE);
+
+	MemoryStats loaded = manager.GetStats();
+	bool aligned = 0 == reinterpret_cast<std::size_t>(cubeMap) % 4096;
+
+	manager.Free(texture);
+	manager.Free(cubeMap);
+	manager.Free(stream);
+	manager.Free(vertex);
+
+	MemoryStats unloaded = manager.GetStats();
+
+	std::cout << "Large objects mapped : " << loaded.largeObjectCount << " over " << loaded.largeObjectBytes / MEM_SIZE::KILO_BYTE 
+			  << " KB in " << loaded.pageCount << " pages, " << ( aligned ? "aligned" : "MISALIGNED" ) << ", left after release : " 
+			  << unloaded.largeObjectCount << ", bytes in use : " << unloaded.bytesInUse << std::endl;
+
+	Check(3 == loaded.largeObjectCount && aligned, "large objects are mapped and aligned");
+	Check(0 == unloaded.largeObjectCount && 0 == unloaded.bytesInUse, "large objects are unmapped on release");
+}
+
+/*
+*	\brief
+*	Asks for sizes no mapping can hold, near the top of a size_t where rounding them 
+*	up wraps around. Every request must fail rather than come back small.
+*/
+void OversizedRequestTest()
+{
+	const std::size_t largest = ~static_cast<std::size_t>(0);
+
+	VariableMemoryManager manager(64 * MEM_SIZE::KILO_BYTE, 32);
+
+	void* vertex = manager.Allocate(sizeof(test_struct));
+	void* batch[2] = { nullptr, nullptr };
+
+	bool rejected = nullptr == manager.Allocate(largest)
+				 && nullptr == manager.Allocate(largest - 7)
+				 && nullptr == manager.AllocateAligned(largest - 7, 64)
+				 && 0 == manager.AllocateBatch(largest - 7, 2, batch)
+				 && VariableMemoryManager::INVALID_HANDLE == manager.AllocateHandle(largest - 7)
+				 && nullptr == manager.Reallocate(vertex, largest - 7);
+
+	manager.Free(vertex);
+
+	VariableMemoryManager arena(64 * MEM_SIZE::KILO_BYTE, 32, true, PAGE_SOURCE_HEAP, LAYOUT_LINEAR);
+
+	rejected = rejected && nullptr == arena.Allocate(largest) && nullptr == arena.Allocate(largest - 3) 
+						&& nullptr == arena.AllocateAligned(largest - 7, 64);
+
+	VariableMemoryManager granular(64 * MEM_SIZE::KILO_BYTE, 32, true, PAGE_SOURCE_HEAP, LAYOUT_BITMAP);
+
+	rejected = rejected && nullptr == granular.Allocate(largest) && nullptr == granular.Allocate(largest - 3) 
+						&& nullptr == granular.AllocateAligned(largest - 7, 64);
+
+	std::cout << "Oversized requests : " << ( rejected ? "rejected" : "HANDED OUT" ) << std::endl;
+
+	Check(rejected, "requests near the top of a size_t fail");
+	Check(0 == manager.GetStats().bytesInUse, "failed requests leave nothing in use");
+	Check(manager.GetStats().largeObjectFailures > 0, "failed mappings are counted");
+}
+
+/*
+*	\brief
+*	Goes past the limits of 32 bit sizes and 16 bit page numbers. An arena of 1 KB pages takes more 
+*	than 65,535 of them, then a region over 4 GB is allocated, as a large object and within a page. 
+*	The huge regions are mapped and barely touched, so they cost address space rather than memory.
+*/
+void HugeHeapTest()
+{
+	VariableMemoryManager arena(MEM_SIZE::KILO_BYTE, 0, true, PAGE_SOURCE_HEAP, LAYOUT_LINEAR);
+
+	const unsigned objectCount = 70000;
+	std::vector<char*> objects(objectCount);
+
+	for ( unsigned i = 0; i < objectCount; ++i )
+	{
+		objects[i] = static_cast<char*>( arena.Allocate(1000) );
+		objects[i][999] = static_cast<char>(i);
+	}
+
+	bool intact = true;
+
+	for ( unsigned i = 0; i < objectCount; ++i )
+		intact = intact && static_cast<char>(i) == objects[i][999] && &arena == arena.OwnerOf(objects[i]);
+
+	std::size_t pages = arena.GetStats().pageCount;
+
+	arena.Reset(0);
+
+	std::cout << "Arena of " << pages << " pages " << ( pages > 65535 && intact ? "intact" : "CORRUPTED" ) 
+			  << ", kept after reset : " << arena.GetStats().pageCount << std::endl;
+
+	Check(pages > 65535 && intact, "arena past 65,535 pages keeps its contents");
+
+	if ( sizeof(std::size_t) <= 4 )
+	{
+		std::cout << "Regions past 4 GB skipped, sizes are 32 bit" << std::endl;
+		return;
+	}
+
+	const std::size_t hugeSize = 4 * static_cast<std::size_t>(MEM_SIZE::GIGA_BYTE) + 64 * MEM_SIZE::KILO_BYTE;
+
+	VariableMemoryManager small(64 * MEM_SIZE::KILO_BYTE, 50);
+	char* large = static_cast<char*>( small.Allocate(hugeSize) );
+
+	if ( nullptr == large )
+	{
+		std::cout << "Regions past 4 GB skipped, no room for the mapping" << std::endl;
+		return;
+	}
+
+	large[0] = 1;
+	large[hugeSize - 1] = 2;
+
+	bool largeOk = small.GetAllocationSize(large) >= hugeSize && small.GetStats().largeObjectBytes > hugeSize;
+	small.Free(large);
+
+	VariableMemoryManager giant(hugeSize + MEM_SIZE::MEGA_BYTE, 0, true, PAGE_SOURCE_MAPPED);
+	char* block = static_cast<char*>( giant.Allocate(hugeSize) );
+
+	block[0] = 1;
+	block[hugeSize - 1] = 2;
+
+	MemoryStats held = giant.GetStats();
+	bool blockOk = giant.GetAllocationSize(block) >= hugeSize && 1 == held.pageCount && held.bytesInUse >= hugeSize;
+
+	giant.Free(block);
+
+	std::cout << "Large object of " << hugeSize / MEM_SIZE::MEGA_BYTE << " MB " << ( largeOk ? "mapped" : "WRONG SIZE" ) 
+			  << ", region of a " << ( hugeSize + MEM_SIZE::MEGA_BYTE ) / MEM_SIZE::MEGA_BYTE << " MB page " << ( blockOk ? "carved" : "WRONG SIZE" ) 
+			  << ", largest free region after release : " << giant.GetStats().largestFreeBlock / MEM_SIZE::MEGA_BYTE << " MB" << std::endl;
+
+	Check(largeOk, "large object past 4 GB is mapped whole");
+	Check(blockOk, "region past 4 GB is carved from its page");
+}
+
+/*
+*	\brief
+*	Unloads a level of assets with a single Reset instead of a Free per asset. The next level must fit 
+*	in the pages kept without requesting new ones. Mapped pages beyond the ones kept committed stay 
+*	with the manager, heap pages beyond them are returned.
+*/
+void ResetTest()
+{
+	VariableMemoryManager mapped(64 * MEM_SIZE::KILO_BYTE, 50, true, PAGE_SOURCE_MAPPED);
+	VariableMemoryManager heap(64 * MEM_SIZE::KILO_BYTE, 50);
+
+	VariableMemoryManager* managers[2] = { &mapped, &heap };
+	const char* names[2] = { "mapped", "heap" };
+
+	for ( unsigned m = 0; m < 2; ++m )
+	{
+		for ( unsigned i = 0; i < 20000; ++i )
+			managers[m]->Allocate(100 + ( i * 7919 ) % 400);
+
+		std::size_t pages = managers[m]->GetStats().pageCount;
+
+		managers[m]->Reset(4);
+
+		MemoryStats afterReset = managers[m]->GetStats();
+
+		for ( unsigned i = 0; i < 20000; ++i )
+			managers[m]->Allocate(100 + ( i * 7919 ) % 400);
+
+		std::cout << "Reset of " << pages << " " << names[m] << " pages keeps " << afterReset.pageCount << ", " 
+				  << ( 0 == afterReset.bytesInUse && afterReset.emptyPageCount == afterReset.pageCount ? "all empty" : "NOT EMPTY" ) 
+				  << ", next level requested " << managers[m]->GetStats().pageRequests - afterReset.pageRequests << " pages" << std::endl;
+
+		Check(0 == afterReset.bytesInUse && afterReset.emptyPageCount == afterReset.pageCount, "Reset leaves every page empty");
+		Check(0 != m || managers[m]->GetStats().pageRequests == afterReset.pageRequests, "mapped pages kept by Reset serve the next level");
+
+		managers[m]->Reset();
+	}
+}
+
+/*
+*	\brief
+*	Builds two frames of temporaries in an arena on top of level data, rolling each frame back 
+*	to the level marker. The second frame must reuse the memory of the first one.
+*/
+void ArenaTest()
+{
+	VariableMemoryManager arena(16 * MEM_SIZE::KILO_BYTE, 0, true, PAGE_SOURCE_HEAP, LAYOUT_LINEAR);
+
+	void* level = arena.Allocate(3000);
+	ArenaMarker frameStart = arena.Mark();
+
+	void* firstFrame[200];
+	void* secondFrame[200];
+
+	for ( unsigned i = 0; i < 200; ++i )
+		firstFrame[i] = arena.Allocate(100 + i % 7);
+
+	void* simd = arena.AllocateAligned(1000, 64);
+	std::size_t pagesUsed = arena.GetStats().pageCount;
+
+	arena.Rollback(frameStart);
+
+	bool reused = true;
+
+	for ( unsigned i = 0; i < 200; ++i )
+	{
+		secondFrame[i] = arena.Allocate(100 + i % 7);
+		reused = reused && secondFrame[i] == firstFrame[i];
+	}
+
+	arena.Rollback(frameStart);
+
+	std::cout << "Arena frame over " << pagesUsed << " pages : " << ( reused ? "reused" : "NOT REUSED" ) 
+			  << ", " << ( 0 == reinterpret_cast<std::size_t>(simd) % 64 ? "aligned" : "MISALIGNED" ) 
+			  << ", level data kept : " << ( arena.GetStats().bytesInUse == 3000 ? "yes" : "NO" ) << std::endl;
+
+	Check(reused, "rolled back arena memory is reused");
+	Check(0 == reinterpret_cast<std::size_t>(simd) % 64, "aligned arena allocation is aligned");
+	Check(arena.GetStats().bytesInUse == 3000, "rollback keeps what was allocated before the marker");
+
+	arena.Free(level);
+	arena.Reset();
+
+	std::cout << "Arena pages released after Reset : " << arena.ReturnUnusedMemory() << std::endl;
+}
+
+/*
+*	\brief
+*	Loads a mesh worth of vertices with a single batch, releases every other one on its own 
+*	and the rest as a batch, after which the page must be back to one free region.
+*/
+void BatchTest()
+{
+	VariableMemoryManager manager(16 * MEM_SIZE::KILO_BYTE, 50);
+
+	void* vertices[256];
+	unsigned allocated = manager.AllocateBatch(sizeof(test_struct), 256, vertices);
+
+	void* remaining[128];
+
+	for ( unsigned i = 0; i < 128; ++i )
+	{
+		manager.Free(vertices[2 * i]);
+		remaining[i] = vertices[2 * i + 1];
+	}
+
+	manager.FreeBatch(remaining, 128);
+
+	std::size_t released = manager.ReturnUnusedMemory();
+
+	std::cout << "Batch allocated : " << allocated << "\tPages released after batch free : " << released << std::endl;
+
+	Check(256 == allocated, "the whole batch is allocated");
+	Check(0 == manager.GetStats().pageCount, "batch free empties the pages");
+}
+
+/*
+*	\brief
+*	Regions are handed out back to back, so the distance between two consecutive 
+*	allocations is the size of one plus the boundary tag in front of the next.
+*/
+void HeaderOverheadTest()
+{
+	VariableMemoryManager manager(16 * MEM_SIZE::KILO_BYTE, 0);
+
+	char* first = static_cast<char*>( manager.Allocate(sizeof(test_struct)) );
+	char* second = static_cast<char*>( manager.Allocate(sizeof(test_struct)) );
+
+	std::cout << "Bytes per " << sizeof(test_struct) << " byte vertex : " << ( second - first ) << std::endl;
+
+	Check(second - first <= static_cast<std::ptrdiff_t>( sizeof(test_struct) + 2 * sizeof(std::size_t) ), "a region costs a single header word");
+
+	manager.Free(second);
+	manager.Free(first);
+}
+
+/*
+*	\brief
+*	The bitmap layout keeps no header between regions, so consecutive vertices
+*	are only apart by their size rounded to a granule.
+*/
+void BitmapLayoutTest()
+{
+	VariableMemoryManager manager(16 * MEM_SIZE::KILO_BYTE, 0, true, PAGE_SOURCE_HEAP, LAYOUT_BITMAP);
+
+	void* vertices[1000];
+
+	for ( unsigned i = 0; i < 1000; ++i )
+		vertices[i] = manager.Allocate(sizeof(test_struct));
+
+	std::ptrdiff_t stride = static_cast<char*>(vertices[1]) - static_cast<char*>(vertices[0]);
+
+	std::cout << "Bytes per " << sizeof(test_struct) << " byte vertex without headers : " << stride << std::endl;
+
+	Check(stride < static_cast<std::ptrdiff_t>( sizeof(test_struct) + 16 ), "bitmap regions carry no header");
+
+	for ( unsigned i = 0; i < 1000; ++i )
+		manager.Free(vertices[i]);
+
+	std::cout << "Pages for 1000 vertices without headers : " << manager.ReturnUnusedMemory() << std::endl;
+}
+
+/*
+*	\brief
+*	Streams assets of mixed sizes in and out under one placement policy, tagging each with 
+*	its index and checking the tags before it is released. Reports the pages the policy needed.
+*/
+template <class FitPolicy>
+void PlacementPolicyTest()
+{
+	BasicVariableMemoryManager<FitPolicy> manager(64 * MEM_SIZE::KILO_BYTE, 50);
+
+	const unsigned slots = 400;
+
+	unsigned char* assets[slots] = {};
+	unsigned sizes[slots] = {};
+	unsigned seed = 2016;
+	bool intact = true;
+
+	for ( unsigned i = 0; i < 20000; ++i )
+	{
+		seed = seed * 1103515245 + 12345;
+
+		unsigned slot = ( seed >> 16 ) % slots;
+
+		if ( assets[slot] )
+		{
+			for ( unsigned j = 0; j < sizes[slot]; ++j )
+				intact = intact && assets[slot][j] == static_cast<unsigned char>(slot);
+
+			manager.Free(assets[slot]);
+		}
+
+		sizes[slot] = ( seed >> 4 ) % 8 ? 32 + ( seed >> 8 ) % 480 : 2048 + ( seed >> 8 ) % 6144;
+		assets[slot] = static_cast<unsigned char*>(manager.Allocate(sizes[slot]));
+
+		std::memset(assets[slot], slot, sizes[slot]);
+	}
+
+	std::cout << FitPolicy::Name() << " : " << manager.GetStats().pageCount << " pages, " 
+			  << ( intact ? "intact" : "CORRUPTED" ) << std::endl;
+
+	Check(intact, "placement policy keeps contents");
+
+	for ( unsigned slot = 0; slot < slots; ++slot )
+		if ( assets[slot] )
+			manager.Free(assets[slot]);
+}
+
+/*
+*	\brief
+*	A skinning matrix palette entry, aligned for the widest SIMD loads
+*/
+struct alignas(64) BoneMatrix
+{
+	float m[16];
+};
+
+/*
+*	\brief
+*	Grows standard containers through ManagerAllocator, and through ManagerResource when 
+*	std::pmr is available, checking the alignment they get and that every byte goes back.
+*/
+void MemoryResourceTest()
+{
+	VariableMemoryManager manager(64 * MEM_SIZE::KILO_BYTE, 50);
+
+	bool aligned = true;
+
+	{
+		ManagerAllocator<BoneMatrix> allocator(manager);
+		std::vector<BoneMatrix, ManagerAllocator<BoneMatrix> > palette(allocator);
+
+		for ( unsigned i = 0; i < 300; ++i )
+		{
+			palette.push_back(BoneMatrix());
+			aligned = aligned && 0 == reinterpret_cast<std::size_t>(palette.data()) % alignof(BoneMatrix);
+		}
+
+		typedef std::pair<const unsigned, float> Entry;
+		std::unordered_map<unsigned, float, std::hash<unsigned>, std::equal_to<unsigned>, ManagerAllocator<Entry> > 
+			weights(16, std::hash<unsigned>(), std::equal_to<unsigned>(), ManagerAllocator<Entry>(manager));
+
+		for ( unsigned i = 0; i < 1000; ++i )
+			weights[i] = i * 0.5f;
+
+		std::cout << "Container memory from the manager : " << manager.GetStats().bytesInUse / MEM_SIZE::KILO_BYTE << " KB" << std::endl;
+	}
+
+	// the byte count of an oversized request would wrap around
+	bool rejected = false;
+
+	try
+	{
+		ManagerAllocator<BoneMatrix> allocator(manager);
+		allocator.allocate(allocator.max_size() + 1);
+	}
+	catch ( const std::bad_array_new_length& )
+	{
+		rejected = true;
+	}
+
+	Check(rejected, "oversized container requests throw std::bad_array_new_length");
+
+	// within max_size, but more bytes than the manager can ever hand out
+	rejected = false;
+
+	try
+	{
+		ManagerAllocator<char> allocator(manager);
+		allocator.deallocate(allocator.allocate(allocator.max_size()), allocator.max_size());
+	}
+	catch ( const std::bad_alloc& )
+	{
+		rejected = true;
+	}
+
+	Check(rejected, "container requests the manager cannot serve throw std::bad_alloc");
+
+#if defined(MEMORY_MANAGER_HAS_PMR)
+	{
+		ManagerResource<> resource(manager);
+		std::pmr::vector<int> indices(&resource);
+
+		for ( int i = 0; i < 10000; ++i )
+			indices.push_back(i);
+
+		void* upload = resource.allocate(4000, 256);
+		aligned = aligned && 0 == reinterpret_cast<std::size_t>(upload) % 256;
+		resource.deallocate(upload, 4000, 256);
+
+		ManagerResource<> other(manager);
+		VariableMemoryManager elsewhere(64 * MEM_SIZE::KILO_BYTE, 50);
+		ManagerResource<> foreign(elsewhere);
+
+		Check(resource == other && resource != foreign, "resources are equal when they share a manager");
+
+		const std::size_t hugeSizes[] = { ~static_cast<std::size_t>(0), ~static_cast<std::size_t>(0) - 20 };
+
+		for ( unsigned i = 0; i < 2; ++i )
+		{
+			bool refused = false;
+
+			try
+			{
+				void* memory = resource.allocate(hugeSizes[i], 8);
+				resource.deallocate(memory, hugeSizes[i], 8);
+			}
+			catch ( const std::bad_alloc& )
+			{
+				refused = true;
+			}
+
+			Check(refused, "resource requests the manager cannot serve throw std::bad_alloc");
+		}
+		Check(resource != *std::pmr::new_delete_resource(), "resources differ from the other kinds");
+	}
+#elif MEMORY_MANAGER_CPLUSPLUS >= 201703L
+	Check(false, "std::pmr is available to a C++17 build");
+#endif
+
+	std::cout << "Containers over the manager : " << ( aligned ? "aligned" : "MISALIGNED" ) 
+			  << ", bytes left in use : " << manager.GetStats().bytesInUse << std::endl;
+
+	Check(aligned, "container memory is aligned");
+	Check(0 == manager.GetStats().bytesInUse, "containers give all their memory back");
+}
+
+/*
+*	\brief
+*	Reports the statistics of a manager after a mix of allocations of various sizes, 
+*	of which every other one is released.
+*/
+void StatsTest()
+{
+	VariableMemoryManager manager(16 * MEM_SIZE::KILO_BYTE, 50);
+
+	void* assets[512];
+
+	for ( unsigned i = 0; i < 512; ++i )
+		assets[i] = manager.Allocate(32 << ( i % 6 ));
+
+	for ( unsigned i = 0; i < 512; i += 2 )
+		manager.Free(assets[i]);
+
+	MemoryStats stats = manager.GetStats();
+
+	std::cout << "Allocations : " << stats.allocations << "\tFrees : " << stats.frees 
+			  << "\tPage requests : " << stats.pageRequests << std::endl;
+	std::cout << "Bytes in use : " << stats.bytesInUse << "\tPeak : " << stats.peakBytesInUse 
+			  << "\tExternal fragmentation : " << stats.externalFragmentation << std::endl;
+
+	Check(512 == stats.allocations && 256 == stats.frees, "statistics count every call");
+
+	for ( unsigned i = 1; i < 512; i += 2 )
+		manager.Free(assets[i]);
+}
+
+/*
+*	\brief
+*	Counts the free regions of a snapshot too small to serve any request of at least minRequest bytes
+*/
+unsigned CountSlivers( const char* fileName, unsigned minRequest )
+{
+	std::ifstream snapshot(fileName, std::ios::binary);
+	SnapshotHeader header;
+	SnapshotPage page;
+	SnapshotRegion region;
+	unsigned slivers = 0;
+
+	snapshot.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	for ( std::uint64_t p = 0; p < header.pageCount && snapshot.read(reinterpret_cast<char*>(&page), sizeof(page)); ++p )
+	{
+		for ( unsigned r = 0; r < page.regionCount && snapshot.read(reinterpret_cast<char*>(&region), sizeof(region)); ++r )
+		{
+			if ( ( region.flags & SNAPSHOT_REGION_AVAILABLE ) && region.size < minRequest )
+				++slivers;
+		}
+	}
+
+	return slivers;
+}
+
+/*
+*	\brief
+*	Loads and unloads levels of meshes, materials and textures, none smaller than a kilobyte, 
+*	with a fixed and with an adaptive fragment threshold. The fixed threshold splits off headroom 
+*	no request will ever fit in, the adaptive one leaves it with the request.
+*/
+void AdaptiveThresholdTest()
+{
+	VariableMemoryManager fixed(256 * MEM_SIZE::KILO_BYTE, 50);
+	VariableMemoryManager adaptive(256 * MEM_SIZE::KILO_BYTE, 50);
+
+	adaptive.SetAdaptiveThreshold(true);
+
+	VariableMemoryManager* managers[2] = { &fixed, &adaptive };
+	const char* dumps[2] = { "../Fixed Threshold.vmms", "../Adaptive Threshold.vmms" };
+
+	for ( unsigned m = 0; m < 2; ++m )
+	{
+		std::vector<void*> level;
+		std::vector<void*> shared;
+		std::vector<void*> nextShared;
+		unsigned seed = 2016;
+
+		for ( unsigned l = 0; l < 20; ++l )
+		{
+			for ( unsigned i = 0; i < 2000; ++i )
+			{
+				seed = seed * 1103515245 + 12345;
+
+				unsigned kind = ( seed >> 16 ) % 100;
+				unsigned size = kind < 50 ? 1000 + ( seed >> 8 ) % 200 : kind < 95 ? 3000 + ( seed >> 8 ) % 500 : 16384 + ( seed >> 8 ) % 4096;
+				void* asset = managers[m]->Allocate(size);
+
+				// a tenth of the assets stays around for the next level
+				if ( i % 10 )
+					level.push_back(asset);
+				else
+					nextShared.push_back(asset);
+			}
+
+			if ( 19 == l )
+				managers[m]->MemoryDump(dumps[m]);
+
+			for ( unsigned i = 0; i < level.size(); ++i )
+				managers[m]->Free(level[( i * 7919 ) % level.size()] );
+
+			for ( unsigned i = 0; i < shared.size(); ++i )
+				managers[m]->Free(shared[i]);
+
+			level.clear();
+			shared.swap(nextShared);
+			nextShared.clear();
+		}
+
+		for ( unsigned i = 0; i < shared.size(); ++i )
+			managers[m]->Free(shared[i]);
+	}
+
+	unsigned fixedSlivers = CountSlivers(dumps[0], 1000);
+	unsigned adaptiveSlivers = CountSlivers(dumps[1], 1000);
+
+	std::cout << "Free regions below 1000 bytes with a fixed threshold : " << fixedSlivers 
+			  << "\tadaptive : " << adaptiveSlivers << std::endl;
+	std::cout << "Adaptive threshold for 1000 byte requests : " << adaptive.GetFragmentThreshold(1000) 
+			  << "\tfor 16384 byte requests : " << adaptive.GetFragmentThreshold(16384) << std::endl;
+
+	Check(adaptiveSlivers < fixedSlivers, "the adaptive threshold leaves fewer unusable free regions");
+}
+
+/*
+*	\brief
+*	Captures a trace of a mix of requests and reads it back. The trace is left next 
+*	to the dumps for TraceReplay.
+*/
+void TraceTest()
+{
+	VariableMemoryManager manager(16 * MEM_SIZE::KILO_BYTE, 50);
+
+	void* assets[256];
+
+	manager.StartTrace("../Allocations.vmmt");
+
+	for ( unsigned i = 0; i < 256; ++i )
+		assets[i] = i % 8 ? manager.Allocate(24 + ( i * 40 ) % 600) : manager.AllocateAligned(64, 64);
+
+	for ( unsigned i = 0; i < 256; i += 3 )
+		assets[i] = manager.Reallocate(assets[i], 700);
+
+	for ( unsigned i = 0; i < 256; ++i )
+		manager.Free(assets[i]);
+
+	manager.StopTrace();
+
+	std::ifstream trace("../Allocations.vmmt", std::ios::binary);
+	TraceHeader header;
+	TraceRecord record;
+	unsigned counts[4] = { 0, 0, 0, 0 };
+
+	trace.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	while ( trace.read(reinterpret_cast<char*>(&record), sizeof(record)) )
+		++counts[record.op];
+
+	std::cout << "Traced allocations : " << counts[TRACE_ALLOCATE] << "\tReallocations : " << counts[TRACE_REALLOCATE] 
+			  << "\tFrees : " << counts[TRACE_FREE] << std::endl;
+
+	Check(256 == counts[TRACE_ALLOCATE] && 86 == counts[TRACE_REALLOCATE] && 256 == counts[TRACE_FREE], "the trace records every call");
+}
+
+/*
+*	\brief
+*	Compares the pages needed for ten thousand vertices with and without the slab tier, 
+*	where each vertex costs its own size instead of its size plus a meta data header. 
+*	Slabs lie back to back, so the slab tier must need fewer pages.
+*/
+void SlabTest()
+{
+	VariableMemoryManager regular(16 * MEM_SIZE::KILO_BYTE, 50);
+	VariableMemoryManager slabbed(16 * MEM_SIZE::KILO_BYTE, 50);
+
+	slabbed.SetSlabLimit(64);
+
+	const unsigned vertexCount = 10000;
+
+	std::vector<void*> regularVertices(vertexCount);
+	std::vector<void*> slabVertices(vertexCount);
+
+	for ( unsigned i = 0; i < vertexCount; ++i )
+	{
+		regularVertices[i] = regular.Allocate(sizeof(test_struct));
+		slabVertices[i] = slabbed.Allocate(sizeof(test_struct));
+	}
+
+	std::size_t regularPages = regular.GetStats().pageCount;
+	std::size_t slabPages = slabbed.GetStats().pageCount;
+
+	for ( unsigned i = 0; i < vertexCount; ++i )
+	{
+		regular.Free(regularVertices[i]);
+		slabbed.Free(slabVertices[i]);
+	}
+
+	std::cout << "Pages for " << vertexCount << " vertices without slabs : " << regularPages 
+			  << "\twith slabs : " << slabPages << std::endl;
+
+	Check(slabPages < regularPages, "slabs need fewer pages than regions with headers");
+	Check(regular.ReturnUnusedMemory() == regularPages && slabbed.ReturnUnusedMemory() == slabPages, "every page is empty once the vertices are gone");
+}
+
+/*
+*	\brief
+*	Appends to a streaming buffer in small steps. As long as the memory behind the buffer is free 
+*	it grows in place, so the address only changes once its neighbour gets in the way.
+*/
+void ReallocateTest()
+{
+	VariableMemoryManager manager(16 * MEM_SIZE::KILO_BYTE, 50);
+
+	char* buffer = static_cast<char*>(manager.Allocate(64));
+	char* original = buffer;
+	unsigned moves = 0;
+
+	for ( unsigned size = 128; size <= 8192; size += 64 )
+	{
+		char* resized = static_cast<char*>(manager.Reallocate(buffer, size));
+
+		if ( resized != buffer )
+			++moves;
+
+		buffer = resized;
+	}
+
+	std::cout << "Reallocate moves while growing : " << moves << ( buffer == original ? " (in place)" : "" ) << std::endl;
+
+	// shrinking never moves
+	char* shrunk = static_cast<char*>(manager.Reallocate(buffer, 256));
+
+	std::cout << "Reallocate shrink : " << ( shrunk == buffer ? "in place" : "MOVED" ) << std::endl;
+
+	Check(shrunk == buffer, "shrinking never moves");
+
+	manager.Free(shrunk);
+}
+
+/*
+*	\brief
+*	Requests huge page backed pages and reports what the system actually provided.
+*/
+void PageSourceTest()
+{
+	const char* modeNames[] = { "None", "Heap", "Mapped", "Transparent huge pages", "Explicit huge pages" };
+
+	VariableMemoryManager manager(4 * MEM_SIZE::MEGA_BYTE, 50, true, PAGE_SOURCE_HUGE_PAGES | PAGE_SOURCE_PREFAULT);
+
+	void* block = manager.Allocate(MEM_SIZE::MEGA_BYTE);
+	manager.Free(block);
+
+	std::cout << "Page source mode : " << modeNames[manager.GetPageSourceMode()] << std::endl;
+
+	Check(nullptr != block, "huge page requests fall back instead of failing");
+}
+
+/*
+*	\brief
+*	A page source of the user's, counting the chunks that go through it
+*/
+class CountingPageSource : public PageSource
+{
+public:
+	explicit CountingPageSource( unsigned _flags = PAGE_SOURCE_HEAP ) : PageSource(_flags) {}
+
+	void* Acquire( std::size_t size, std::size_t alignment )
+	{
+		++acquired;
+		return PageSource::Acquire(size, alignment);
+	}
+
+	void Release( void* chunk, std::size_t size )
+	{
+		++released;
+		PageSource::Release(chunk, size);
+	}
+
+	static unsigned acquired;
+	static unsigned released;
+};
+
+unsigned CountingPageSource::acquired = 0;
+unsigned CountingPageSource::released = 0;
+
+/*
+*	\brief
+*	Builds a manager on a page source the library knows nothing about, which only 
+*	links because the definitions of the manager are in its header.
+*/
+void CustomPageSourceTest()
+{
+	std::size_t pages = 0;
+
+	{
+		BasicVariableMemoryManager<BestFit, CountingPageSource> manager(16 * MEM_SIZE::KILO_BYTE, 50);
+
+		std::vector<void*> meshes;
+
+		for ( unsigned i = 0; i < 64; ++i )
+			meshes.push_back(manager.Allocate(1000));
+
+		pages = manager.GetStats().pageCount;
+
+		for ( std::size_t i = 0; i < meshes.size(); ++i )
+			manager.Free(meshes[i]);
+	}
+
+	std::cout << "Custom page source : " << CountingPageSource::acquired << " chunks acquired, " 
+			  << CountingPageSource::released << " released, for " << pages << " pages" << std::endl;
+
+	Check(pages > 1 && CountingPageSource::acquired == pages, "every page comes from the custom page source");
+	Check(CountingPageSource::released == CountingPageSource::acquired, "every chunk goes back to the custom page source");
+}
+
+/*
+*	\brief
+*	Starts threads one after the other, each allocating a few blocks and leaving half of them 
+*	to the main thread, which frees them remotely. Exited threads hand their manager on, 
+*	so a single one serves them all.
+*/
+void ThreadChurnTest()
+{
+	ConcurrentMemoryManager manager(64 * MEM_SIZE::KILO_BYTE, 50);
+
+	std::vector<void*> leftovers;
+
+	for ( unsigned round = 0; round < 100; ++round )
+	{
+		std::thread worker([&manager, &leftovers]()
+		{
+			void* blocks[64];
+
+			for ( unsigned i = 0; i < 64; ++i )
+				blocks[i] = manager.Allocate(100 + i * 10);
+
+			for ( unsigned i = 0; i < 64; i += 2 )
+			{
+				manager.Free(blocks[i]);
+				leftovers.push_back(blocks[i + 1]);
+			}
+		});
+
+		worker.join();
+
+		for ( unsigned i = 0; i < leftovers.size(); ++i )
+			manager.Free(leftovers[i]);
+
+		leftovers.clear();
+	}
+
+	std::cout << "Managers after 100 threads : " << manager.GetHeapCount() << std::endl;
+
+	Check(1 == manager.GetHeapCount(), "exited threads hand their manager on");
+}
+
+/*
+*	\brief
+*	A worker resizes memory of the main thread, which is still running. A mesh needs its 
+*	size passed in, a texture mapping of its own keeps it where any thread can read it.
+*/
+void RemoteReallocateTest()
+{
+	ConcurrentMemoryManager manager(64 * MEM_SIZE::KILO_BYTE, 50);
+
+	void* mesh = manager.Allocate(200);
+	void* texture = manager.Allocate(256 * MEM_SIZE::KILO_BYTE);
+
+	std::memset(mesh, 0x5A, 200);
+	std::memset(texture, 0x3C, 4096);
+
+	void* unsized = nullptr;
+	void* resized = nullptr;
+	void* remapped = nullptr;
+
+	std::thread worker([&]()
+	{
+		unsized = manager.Reallocate(mesh, 400);
+		resized = manager.Reallocate(mesh, 200, 400);
+		remapped = manager.Reallocate(texture, 512 * MEM_SIZE::KILO_BYTE);
+	});
+
+	worker.join();
+
+	bool intact = nullptr != resized && nullptr != remapped;
+
+	for ( unsigned i = 0; intact && i < 200; ++i )
+		intact = 0x5A == static_cast<unsigned char*>(resized)[i];
+
+	for ( unsigned i = 0; intact && i < 4096; ++i )
+		intact = 0x3C == static_cast<unsigned char*>(remapped)[i];
+
+	std::cout << "Remote reallocation : " << ( intact ? "contents intact" : "CORRUPTED" ) << std::endl;
+
+	Check(nullptr == unsized, "memory of another thread is not sized from its owner's pages");
+	Check(intact, "memory of another thread keeps its contents when resized");
+
+	manager.Free(resized);
+	manager.Free(remapped);
 }
 
 int main ()
 {
 	SequenceCorrectnessTest();
 
+	ReturnUnusedMemoryTest();
+
+	AlignedAllocationTest();
+
+	ReallocateTest();
+
+	BatchTest();
+
+	HeaderOverheadTest();
+
+	BitmapLayoutTest();
+
+	PlacementPolicyTest<WorstFit>();
+	PlacementPolicyTest<BestFit>();
+	PlacementPolicyTest<FirstFit>();
+	PlacementPolicyTest<NextFit>();
+
+	MemoryResourceTest();
+
+	StatsTest();
+
+	TraceTest();
+
+	AdaptiveThresholdTest();
+
+	HandleCompactionTest();
+
+	ArenaTest();
+
+	ResetTest();
+
+	LargeObjectTest();
+
+	OversizedRequestTest();
+
+	HugeHeapTest();
+
+	SlabTest();
+
+	ThreadChurnTest();
+
+	RemoteReallocateTest();
+
+	PageSourceTest();
+
+	CustomPageSourceTest();
+
+	std::cout << ( failedChecks ? "Checks failed : " : "All checks passed" );
+
+	if ( failedChecks )
+		std::cout << failedChecks;
+
+	std::cout << std::endl;
+
+#if defined(_WIN32)
 	system("PAUSE");
+#endif
 
-	return 0;
+	return failedChecks ? EXIT_FAILURE : EXIT_SUCCESS;
 }
\ No newline at end of file
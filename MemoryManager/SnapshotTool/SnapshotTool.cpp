@@ -0,0 +1,279 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 Xavier RX Tan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in the
+Software without restriction, including without limitation the rights to use, copy,
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the
+following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/****************************************************
+Author : Xavier Tan
+Email  : xavier.rx.tan@gmail.com / tan.ruixiang@digipen.edu
+
+SnapshotTool.cpp
+
+*****************************************************/
+
+/**
+	\file SnapshotTool.cpp
+	\brief
+		Offline reader of the binary snapshots written by VariableMemoryManager::MemoryDump.
+		For every page it prints an occupancy map and the figures that matter when tuning
+		the page size and the fragmentation threshold, followed by a summary of the heap.
+
+		Usage : SnapshotTool snapshot.vmms [columns]
+
+		Occupancy map legend, one character per pageSize / columns bytes:
+		- '#' handed out
+		- 'S' handed out as a slab of small slots
+		- '.' free
+		- '+' partly free
+		- ' ' allocator meta data only
+*/
+
+#include "../MemoryManager/HeapSnapshot.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/**
+	\brief
+		Byte counts of one character of the occupancy map
+*/
+struct Cell
+{
+	std::uint64_t used;		/**< bytes handed out*/
+	std::uint64_t free;		/**< bytes free*/
+	bool		  slab;		/**< a slab overlaps the cell*/
+};
+
+/**
+	\brief
+		Figures gathered over the pages
+*/
+struct Totals
+{
+	std::uint64_t used;				/**< bytes handed out*/
+	std::uint64_t free;				/**< bytes free*/
+	std::uint64_t largestFree;		/**< largest free region of the heap*/
+	std::uint64_t usedRegions;		/**< regions handed out*/
+	std::uint64_t freeRegions;		/**< free regions*/
+	std::uint64_t freeSizes[64];	/**< free regions per power of two of their size*/
+};
+
+/*
+*	\brief
+*	Index of the most significant set bit, 0 for 0
+*/
+static unsigned Log2( std::uint64_t value )
+{
+	unsigned log = 0;
+
+	while ( value >>= 1 )
+		++log;
+
+	return log;
+}
+
+/*
+*	\brief
+*	Spread a region over the cells it overlaps
+*/
+static void AddToCells( std::vector<Cell>& cells, std::uint64_t cellSize, const SnapshotRegion& region )
+{
+	std::uint64_t start = region.offset;
+	std::uint64_t end = region.offset + region.size;
+
+	while ( start < end )
+	{
+		std::uint64_t index = start / cellSize;
+		std::uint64_t cellEnd = ( index + 1 ) * cellSize;
+		std::uint64_t bytes = ( end < cellEnd ? end : cellEnd ) - start;
+
+		if ( index >= cells.size() )
+			break;
+
+		if ( region.flags & SNAPSHOT_REGION_AVAILABLE )
+			cells[index].free += bytes;
+		else
+			cells[index].used += bytes;
+
+		if ( region.flags & SNAPSHOT_REGION_SLAB )
+			cells[index].slab = true;
+
+		start += bytes;
+	}
+}
+
+/*
+*	\brief
+*	Character of a cell of the occupancy map
+*/
+static char CellCharacter( const Cell& cell )
+{
+	if ( cell.slab )
+		return 'S';
+
+	if ( 0 == cell.free )
+		return cell.used ? '#' : ' ';
+
+	return cell.used ? '+' : '.';
+}
+
+/*
+*	\brief
+*	Print the occupancy map and figures of every page, then the summary
+*/
+int main( int argc, char** argv )
+{
+	if ( argc < 2 )
+	{
+		std::cout << "Usage : SnapshotTool snapshot.vmms [columns]" << std::endl;
+		return 1;
+	}
+
+	unsigned columns = argc > 2 ? static_cast<unsigned>( atoi(argv[2]) ) : 64;
+
+	if ( 0 == columns )
+		columns = 64;
+
+	std::ifstream file(argv[1], std::ios::binary);
+
+	if ( !file )
+	{
+		std::cout << "Cannot open " << argv[1] << std::endl;
+		return 1;
+	}
+
+	std::vector<char> snapshot( ( std::istreambuf_iterator<char>(file) ), std::istreambuf_iterator<char>() );
+	std::size_t position = 0;
+
+	SnapshotHeader header;
+
+	if ( snapshot.size() < sizeof(header) )
+	{
+		std::cout << "Not a snapshot" << std::endl;
+		return 1;
+	}
+
+	memcpy(&header, &snapshot[0], sizeof(header));
+	position += sizeof(header);
+
+	if ( memcmp(header.magic, SnapshotMagic, sizeof(header.magic)) || SNAPSHOT_FORMAT_VERSION != header.version )
+	{
+		std::cout << "Not a snapshot of format version " << SNAPSHOT_FORMAT_VERSION << std::endl;
+		return 1;
+	}
+
+	if ( columns > header.pageSize )
+		columns = static_cast<unsigned>(header.pageSize);
+
+	std::uint64_t cellSize = ( header.pageSize + columns - 1 ) / columns;
+
+	std::cout << "Page size : " << header.pageSize << "\tPages : " << header.pageCount 
+			  << "\tLayout : " << ( 2 == header.layout ? "linear" : header.layout ? "bitmap" : "inline" ) << std::endl;
+
+	Totals totals;
+	memset(&totals, 0, sizeof(totals));
+
+	for ( std::uint64_t pageIndex = 0; pageIndex < header.pageCount; ++pageIndex )
+	{
+		SnapshotPage page;
+
+		if ( position + sizeof(page) > snapshot.size() )
+		{
+			std::cout << "Snapshot is truncated" << std::endl;
+			return 1;
+		}
+
+		memcpy(&page, &snapshot[position], sizeof(page));
+		position += sizeof(page);
+
+		if ( position + std::size_t(page.regionCount) * sizeof(SnapshotRegion) > snapshot.size() )
+		{
+			std::cout << "Snapshot is truncated" << std::endl;
+			return 1;
+		}
+
+		std::vector<Cell> cells(columns);
+		memset(&cells[0], 0, columns * sizeof(Cell));
+
+		std::uint64_t pageFree = 0;
+		std::uint64_t pageLargest = 0;
+
+		for ( std::uint32_t i = 0; i < page.regionCount; ++i )
+		{
+			SnapshotRegion region;
+			memcpy(&region, &snapshot[position], sizeof(region));
+			position += sizeof(region);
+
+			AddToCells(cells, cellSize, region);
+
+			if ( region.flags & SNAPSHOT_REGION_AVAILABLE )
+			{
+				pageFree += region.size;
+				++totals.freeRegions;
+				++totals.freeSizes[ Log2(region.size) ];
+
+				if ( region.size > pageLargest )
+					pageLargest = region.size;
+			}
+			else
+			{
+				totals.used += region.size;
+				++totals.usedRegions;
+			}
+		}
+
+		if ( header.flags & SNAPSHOT_CONTENTS )
+			position += static_cast<std::size_t>(header.pageSize);
+
+		totals.free += pageFree;
+
+		if ( pageLargest > totals.largestFree )
+			totals.largestFree = pageLargest;
+
+		std::string map(columns, ' ');
+
+		for ( unsigned c = 0; c < columns; ++c )
+			map[c] = CellCharacter(cells[c]);
+
+		std::cout << "Page " << pageIndex << "\t[" << map << "]\tfree : " << pageFree 
+				  << "\tlargest free : " << pageLargest << "\tfragmentation : " 
+				  << ( pageFree ? 1.0 - double(pageLargest) / double(pageFree) : 0.0 ) << std::endl;
+	}
+
+	std::cout << std::endl;
+	std::cout << "Used : " << totals.used << " bytes in " << totals.usedRegions << " regions" << std::endl;
+	std::cout << "Free : " << totals.free << " bytes in " << totals.freeRegions << " regions" << std::endl;
+	std::cout << "Largest free region : " << totals.largestFree << std::endl;
+	std::cout << "External fragmentation : " << ( totals.free ? 1.0 - double(totals.largestFree) / double(totals.free) : 0.0 ) << std::endl;
+	std::cout << "Free regions by size :" << std::endl;
+
+	for ( unsigned i = 0; i < 64; ++i )
+	{
+		if ( totals.freeSizes[i] )
+			std::cout << "\t[" << ( 1ull << i ) << ", " << ( 2ull << i ) << ")\t" << totals.freeSizes[i] << std::endl;
+	}
+
+	return 0;
+}
\ No newline at end of file
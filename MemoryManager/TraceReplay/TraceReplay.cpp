@@ -0,0 +1,460 @@
+/*
+The MIT License (MIT)
+Copyright (c) 2016 Xavier RX Tan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in the
+Software without restriction, including without limitation the rights to use, copy,
+modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the
+following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/****************************************************
+Author : Xavier Tan
+Email  : xavier.rx.tan@gmail.com / tan.ruixiang@digipen.edu
+
+TraceReplay.cpp
+
+*****************************************************/
+
+/**
+	\file TraceReplay.cpp
+	\brief
+		Replays a trace captured with VariableMemoryManager::StartTrace against a grid of 
+		configurations, so the page size, fragment threshold and policy are tuned from the 
+		requests of the real application rather than guessed.
+
+		Usage : TraceReplay trace.vmmt [pageSizes] [fragmentThresholds] [policies]
+
+		Every list is comma separated. Policies are 
+		- inline : boundary tags and free lists
+		- slab	 : inline with slabs serving the small requests
+		- bitmap : granule bitmaps, the fragment threshold plays no part
+		- adaptive : inline with the fragment threshold following the request sizes, 
+		  starting from the given threshold
+		By default the captured page size is tried along with half, twice and four times it, 
+		the captured threshold along with 0, 16, 64 and 256, and every policy.
+
+		For every configuration the report gives the pages requested, which is the peak page 
+		count since the replay never trims, the memory they add up to, the peak of the bytes 
+		handed out, the share of the page memory they used at best and the replay time. 
+		Requests too large for the page size are mapped on their own, their number is added 
+		to the line but their memory is not part of the page memory.
+*/
+
+#include "../MemoryManager/AllocationTrace.h"
+#include "../MemoryManager/MemoryManager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef std::chrono::steady_clock ReplayClock;
+
+/**
+	\enum REPLAY_POLICY
+	\brief
+		How the replaying manager is set up
+*/
+enum REPLAY_POLICY
+{
+	POLICY_INLINE = 0,
+	POLICY_SLAB,
+	POLICY_BITMAP,
+	POLICY_ADAPTIVE,
+	POLICY_COUNT
+};
+
+static const char* PolicyNames[] = { "inline", "slab", "bitmap", "adaptive" };
+
+/**
+	\brief
+		A request of the trace, with the captured addresses turned into dense ids
+*/
+struct ReplayOp
+{
+	unsigned op;			/**< TRACE_ALLOCATE, TRACE_FREE, TRACE_REALLOCATE or TRACE_RESET*/
+	unsigned id;			/**< index of the memory among every memory of the trace*/
+	std::size_t size;		/**< requested size*/
+	unsigned alignment;		/**< requested alignment, 0 for plain requests*/
+};
+
+/**
+	\brief
+		Figures of one configuration
+*/
+struct ReplayResult
+{
+	std::size_t	  pageSize;
+	std::size_t	  fragmentThreshold;
+	REPLAY_POLICY policy;
+	unsigned long long pages;		/**< pages requested*/
+	std::size_t	  peakBytesInUse;	/**< most bytes handed out at once*/
+	double		  milliseconds;		/**< replay time*/
+	unsigned	  failures;			/**< requests the manager could not satisfy*/
+	unsigned long long largeObjects; /**< requests too large for a page, mapped on their own*/
+};
+
+/*
+*	\brief
+*	Parse a comma separated list of numbers, or of policy names when names is given
+*/
+static std::vector<std::size_t> ParseList( const char* text, const char** names = nullptr, unsigned nameCount = 0 )
+{
+	std::vector<std::size_t> values;
+	std::string list(text);
+	std::size_t begin = 0;
+
+	while ( begin <= list.size() )
+	{
+		std::size_t end = list.find(',', begin);
+
+		if ( end == std::string::npos )
+			end = list.size();
+
+		std::string item = list.substr(begin, end - begin);
+
+		if ( !item.empty() )
+		{
+			if ( names )
+			{
+				for ( unsigned i = 0; i < nameCount; ++i )
+				{
+					if ( item == names[i] )
+						values.push_back(i);
+				}
+			}
+			else
+			{
+				values.push_back(static_cast<std::size_t>( strtoull(item.c_str(), nullptr, 10) ));
+			}
+		}
+
+		begin = end + 1;
+	}
+
+	return values;
+}
+
+/*
+*	\brief
+*	Turn the records into requests on dense ids so the replay indexes an array rather 
+*	than looking up addresses. Releases of memory allocated before the trace started 
+*	are dropped. Returns the number of ids.
+*/
+static unsigned PrepareOps( const std::vector<TraceRecord>& records, std::vector<ReplayOp>& ops, std::size_t& largestRequest )
+{
+	std::unordered_map<std::uint64_t, unsigned> live;
+	unsigned ids = 0;
+
+	largestRequest = 0;
+
+	for ( std::size_t i = 0; i < records.size(); ++i )
+	{
+		const TraceRecord& record = records[i];
+		ReplayOp op = { static_cast<unsigned>(record.op), 0, static_cast<std::size_t>(record.size), record.alignment ? 1u << record.alignment : 0u };
+
+		if ( TRACE_ALLOCATE == record.op )
+		{
+			op.id = live[record.object] = ids++;
+		}
+		else if ( TRACE_FREE == record.op )
+		{
+			std::unordered_map<std::uint64_t, unsigned>::iterator found = live.find(record.object);
+
+			if ( found == live.end() )
+				continue;
+
+			op.id = found->second;
+			live.erase(found);
+		}
+		else if ( TRACE_REALLOCATE == record.op && i + 1 < records.size() && TRACE_REALLOCATED == records[i + 1].op )
+		{
+			std::unordered_map<std::uint64_t, unsigned>::iterator found = live.find(record.object);
+
+			++i;
+
+			if ( found == live.end() )
+			{
+				// resizing memory of before the trace, replayed as a fresh allocation
+				op.op = TRACE_ALLOCATE;
+				op.id = ids++;
+			}
+			else
+			{
+				op.id = found->second;
+				live.erase(found);
+			}
+
+			live[records[i].object] = op.id;
+		}
+		else if ( TRACE_RESET == record.op )
+		{
+			// the pages to keep are no request size
+			live.clear();
+			ops.push_back(op);
+			continue;
+		}
+		else
+		{
+			continue;
+		}
+
+		largestRequest = std::max(largestRequest, op.size + op.alignment);
+
+		ops.push_back(op);
+	}
+
+	return ids;
+}
+
+/*
+*	\brief
+*	Replay the requests on a manager of the given configuration
+*/
+static ReplayResult Replay( const std::vector<ReplayOp>& ops, unsigned ids, std::size_t pageSize, std::size_t fragmentThreshold, REPLAY_POLICY policy )
+{
+	ReplayResult result = { pageSize, fragmentThreshold, policy, 0, 0, 0.0, 0, 0 };
+	std::vector<void*> objects(ids, nullptr);
+
+	VariableMemoryManager* manager = new VariableMemoryManager(pageSize, fragmentThreshold, true, PAGE_SOURCE_HEAP, 
+															   POLICY_BITMAP == policy ? LAYOUT_BITMAP : LAYOUT_INLINE);
+
+	// clamped to the largest slot size the slabs support
+	if ( POLICY_SLAB == policy )
+		manager->SetSlabLimit(~0u);
+
+	if ( POLICY_ADAPTIVE == policy )
+		manager->SetAdaptiveThreshold(true);
+
+	ReplayClock::time_point start = ReplayClock::now();
+
+	for ( std::size_t i = 0; i < ops.size(); ++i )
+	{
+		const ReplayOp& op = ops[i];
+		void*& object = objects[op.id];
+
+		switch ( op.op )
+		{
+		case TRACE_ALLOCATE:
+			object = op.alignment ? manager->AllocateAligned(op.size, op.alignment) : manager->Allocate(op.size);
+			result.failures += nullptr == object;
+			break;
+
+		case TRACE_FREE:
+			if ( object )
+				manager->Free(object);
+			object = nullptr;
+			break;
+
+		case TRACE_REALLOCATE:
+			if ( object )
+			{
+				void* resized = manager->Reallocate(object, op.size);
+
+				if ( resized || 0 == op.size )
+					object = resized;
+				else
+					++result.failures;
+			}
+			break;
+
+		case TRACE_RESET:
+			manager->Reset(static_cast<std::size_t>(op.size));
+			std::fill(objects.begin(), objects.end(), nullptr);
+			break;
+		}
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = ReplayClock::now() - start;
+
+	MemoryStats stats = manager->GetStats();
+
+	result.pages = stats.pageRequests;
+	result.largeObjects = stats.largeObjectMaps;
+	result.peakBytesInUse = stats.peakBytesInUse;
+	result.milliseconds = elapsed.count();
+
+	for ( unsigned i = 0; i < ids; ++i )
+	{
+		if ( objects[i] )
+			manager->Free(objects[i]);
+	}
+
+	delete manager;
+
+	return result;
+}
+
+/*
+*	\brief
+*	Print one line of the report
+*/
+static void Report( const ReplayResult& result )
+{
+	double memory = static_cast<double>(result.pages) * result.pageSize;
+
+	std::cout << result.pageSize << "\t";
+
+	if ( POLICY_BITMAP == result.policy )
+		std::cout << "-";
+	else
+		std::cout << result.fragmentThreshold;
+
+	std::cout << "\t" << PolicyNames[result.policy] << "\t" << result.pages
+			  << "\t" << memory / MEM_SIZE::KILO_BYTE << "\t" << result.peakBytesInUse / MEM_SIZE::KILO_BYTE
+			  << "\t" << ( memory > 0.0 ? result.peakBytesInUse / memory : 0.0 )
+			  << "\t" << result.milliseconds;
+
+	if ( result.failures )
+		std::cout << "\tfailed requests : " << result.failures;
+
+	if ( result.largeObjects )
+		std::cout << "\tlarge objects : " << result.largeObjects;
+
+	std::cout << std::endl;
+}
+
+int main( int argc, char** argv )
+{
+	if ( argc < 2 )
+	{
+		std::cout << "Usage : TraceReplay trace.vmmt [pageSizes] [fragmentThresholds] [policies]" << std::endl;
+		return 1;
+	}
+
+	std::ifstream file(argv[1], std::ios::binary);
+
+	if ( !file )
+	{
+		std::cout << "Cannot open " << argv[1] << std::endl;
+		return 1;
+	}
+
+	std::vector<char> trace( ( std::istreambuf_iterator<char>(file) ), std::istreambuf_iterator<char>() );
+	TraceHeader header;
+
+	if ( trace.size() < sizeof(header) )
+	{
+		std::cout << "Not a trace" << std::endl;
+		return 1;
+	}
+
+	memcpy(&header, &trace[0], sizeof(header));
+
+	if ( memcmp(header.magic, TraceMagic, sizeof(header.magic)) || TRACE_FORMAT_VERSION != header.version || sizeof(TraceRecord) != header.recordSize )
+	{
+		std::cout << "Not a trace of format version " << TRACE_FORMAT_VERSION << std::endl;
+		return 1;
+	}
+
+	std::vector<TraceRecord> records( ( trace.size() - sizeof(header) ) / sizeof(TraceRecord) );
+
+	if ( !records.empty() )
+		memcpy(&records[0], &trace[sizeof(header)], records.size() * sizeof(TraceRecord));
+
+	std::vector<ReplayOp> ops;
+	std::size_t largestRequest = 0;
+	unsigned ids = PrepareOps(records, ops, largestRequest);
+
+	std::cout << "Captured with page size : " << header.pageSize << "\tfragment threshold : " << header.fragmentThreshold 
+			  << "\tlayout : " << ( LAYOUT_LINEAR == header.layout ? "linear" : LAYOUT_BITMAP == header.layout ? "bitmap" : "inline" ) << std::endl;
+	std::cout << "Requests : " << ops.size() << "\tLargest request : " << largestRequest;
+
+	if ( !records.empty() )
+		std::cout << "\tCaptured over : " << records.back().time / 1000000.0 << " ms";
+
+	std::cout << std::endl;
+
+	std::vector<std::size_t> pageSizes, thresholds, policies;
+
+	if ( argc > 2 )
+	{
+		pageSizes = ParseList(argv[2]);
+	}
+	else
+	{
+		std::size_t captured = static_cast<std::size_t>(header.pageSize);
+
+		pageSizes.push_back(captured / 2);
+		pageSizes.push_back(captured);
+		pageSizes.push_back(captured * 2);
+		pageSizes.push_back(captured * 4);
+	}
+
+	if ( argc > 3 )
+	{
+		thresholds = ParseList(argv[3]);
+	}
+	else
+	{
+		std::size_t defaults[] = { 0, 16, 64, 256, static_cast<std::size_t>(header.fragmentThreshold) };
+		thresholds.assign(defaults, defaults + 5);
+		std::sort(thresholds.begin(), thresholds.end());
+		thresholds.erase(std::unique(thresholds.begin(), thresholds.end()), thresholds.end());
+	}
+
+	if ( argc > 4 )
+		policies = ParseList(argv[4], PolicyNames, POLICY_COUNT);
+	else
+		policies = ParseList("inline,slab,bitmap,adaptive", PolicyNames, POLICY_COUNT);
+
+	std::cout << "Page size\tThreshold\tPolicy\tPages\tMemory KB\tPeak in use KB\tUse\tms" << std::endl;
+
+	std::vector<ReplayResult> results;
+
+	for ( std::size_t s = 0; s < pageSizes.size(); ++s )
+	{
+		for ( std::size_t p = 0; p < policies.size(); ++p )
+		{
+			for ( std::size_t t = 0; t < thresholds.size(); ++t )
+			{
+				results.push_back(Replay(ops, ids, pageSizes[s], thresholds[t], static_cast<REPLAY_POLICY>(policies[p])));
+				Report(results.back());
+
+				// the bitmap layout ignores the threshold, once is enough
+				if ( POLICY_BITMAP == policies[p] )
+					break;
+			}
+		}
+	}
+
+	if ( results.empty() )
+		return 0;
+
+	std::size_t leastMemory = 0, fastest = 0;
+
+	for ( std::size_t i = 1; i < results.size(); ++i )
+	{
+		if ( results[i].pages * results[i].pageSize < results[leastMemory].pages * results[leastMemory].pageSize )
+			leastMemory = i;
+
+		if ( results[i].milliseconds < results[fastest].milliseconds )
+			fastest = i;
+	}
+
+	std::cout << std::endl << "Least memory :" << std::endl;
+	Report(results[leastMemory]);
+	std::cout << "Fastest :" << std::endl;
+	Report(results[fastest]);
+
+	return 0;
+}
\ No newline at end of file